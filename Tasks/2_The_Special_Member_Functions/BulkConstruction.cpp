@@ -0,0 +1,317 @@
+/**************************************************************************************************
+*
+* \file BulkConstruction.cpp
+* \brief C++ Training - Example for the parallel bulk construction of large arrays
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the serial construction of 5M identical strings via 'std::vector::emplace_back()'
+*       with the bulk construction into uninitialized storage by a varying number of threads.
+*       Examine the effect of per-thread memory resources on the scaling behavior and convince
+*       yourself that 'BulkArray' provides the strong exception safety guarantee.
+*
+**************************************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+//---- <BulkArray.h> ------------------------------------------------------------------------------
+
+// Constructs all elements in the range [first,last) via the given construction function. In case
+// of an exception, all elements constructed so far are destroyed before the exception is rethrown.
+template< typename T, typename Construct >
+void construct_range( T* first, T* last, Construct construct )
+{
+   T* current{ first };
+   try {
+      for( ; current!=last; ++current ) {
+         construct( current );
+      }
+   }
+   catch( ... ) {
+      std::destroy( first, current );
+      throw;
+   }
+}
+
+
+// Fixed-size array, whose elements are copy constructed in parallel from a single value. Every
+// thread constructs a contiguous chunk of the array. For allocator-aware types (as for instance
+// 'std::pmr::string'), every chunk is given its own memory resource, such that the threads don't
+// contend on the global allocator. In case any construction fails, all constructed elements are
+// destroyed, the storage is released, and the first exception is rethrown (strong guarantee).
+template< typename T >
+class BulkArray
+{
+ public:
+   using value_type     = T;
+   using iterator       = T*;
+   using const_iterator = T const*;
+
+   BulkArray( std::size_t n, T const& value,
+              std::size_t threads = std::thread::hardware_concurrency() )
+      : data_{ std::allocator<T>{}.allocate( n ) }
+      , size_{ n }
+   {
+      // Releasing the storage in case anything in the constructor throws
+      std::unique_ptr<T,Deallocate> storage{ data_, Deallocate{ size_ } };
+
+      threads = std::clamp( threads, std::size_t{1}, std::max( n, std::size_t{1} ) );
+
+      if constexpr( uses_memory_resource ) {
+         for( std::size_t t=0UL; t<threads; ++t ) {
+            resources_.push_back( std::make_unique<std::pmr::monotonic_buffer_resource>() );
+         }
+      }
+
+      std::vector<std::exception_ptr> errors( threads );
+
+      auto const construct_chunk = [&]( std::size_t t )
+      {
+         T* const first = data_ + begin_of_chunk( t, threads );
+         T* const last  = data_ + begin_of_chunk( t+1UL, threads );
+
+         try {
+            if constexpr( uses_memory_resource ) {
+               std::pmr::polymorphic_allocator<T> alloc{ resources_[t].get() };
+               construct_range( first, last, [&]( T* p ){
+                  std::uninitialized_construct_using_allocator( p, alloc, value );
+               } );
+            }
+            else {
+               std::uninitialized_fill( first, last, value );
+            }
+         }
+         catch( ... ) {
+            errors[t] = std::current_exception();
+         }
+      };
+
+      if( threads == 1UL ) {
+         construct_chunk( 0UL );
+      }
+      else {
+         std::vector<std::jthread> workers{};
+         std::size_t started{ 1UL };
+         try {
+            workers.reserve( threads-1UL );
+            for( ; started<threads; ++started ) {
+               workers.emplace_back( construct_chunk, started );
+            }
+         }
+         catch( ... ) {
+            // The chunks of the threads, which could not be started, remain unconstructed
+            std::fill( errors.begin()+started, errors.end(), std::current_exception() );
+         }
+         construct_chunk( 0UL );
+      }  // Joining all threads
+
+      auto const failed =
+         std::find_if( errors.begin(), errors.end(), []( auto const& e ){ return e != nullptr; } );
+
+      if( failed != errors.end() ) {
+         for( std::size_t t=0UL; t<threads; ++t ) {
+            if( errors[t] == nullptr ) {
+               std::destroy( data_ + begin_of_chunk( t, threads ),
+                             data_ + begin_of_chunk( t+1UL, threads ) );
+            }
+         }
+         std::rethrow_exception( *failed );
+      }
+
+      storage.release();
+   }
+
+   ~BulkArray()
+   {
+      if( data_ != nullptr ) {
+         std::destroy( data_, data_+size_ );
+         std::allocator<T>{}.deallocate( data_, size_ );
+      }
+   }
+
+   BulkArray( BulkArray const& ) = delete;
+   BulkArray& operator=( BulkArray const& ) = delete;
+
+   BulkArray( BulkArray&& other ) noexcept
+      : data_{ std::exchange( other.data_, nullptr ) }
+      , size_{ std::exchange( other.size_, 0UL ) }
+      , resources_{ std::move(other.resources_) }
+   {}
+
+   BulkArray& operator=( BulkArray&& other ) noexcept
+   {
+      BulkArray tmp{ std::move(other) };
+      std::swap( data_, tmp.data_ );
+      std::swap( size_, tmp.size_ );
+      std::swap( resources_, tmp.resources_ );
+      return *this;
+   }
+
+   std::size_t size() const noexcept { return size_; }
+
+   T&       operator[]( std::size_t i )       noexcept { return data_[i]; }
+   T const& operator[]( std::size_t i ) const noexcept { return data_[i]; }
+
+   iterator       begin()       noexcept { return data_; }
+   const_iterator begin() const noexcept { return data_; }
+   iterator       end()         noexcept { return data_+size_; }
+   const_iterator end()   const noexcept { return data_+size_; }
+
+ private:
+   static constexpr bool uses_memory_resource =
+      std::uses_allocator_v<T,std::pmr::polymorphic_allocator<T>>;
+
+   struct Deallocate
+   {
+      std::size_t n;
+      void operator()( T* p ) const noexcept { std::allocator<T>{}.deallocate( p, n ); }
+   };
+
+   std::size_t begin_of_chunk( std::size_t t, std::size_t threads ) const noexcept
+   {
+      return ( size_ / threads ) * t + std::min( t, size_ % threads );
+   }
+
+   T* data_{ nullptr };
+   std::size_t size_{ 0UL };
+   std::vector<std::unique_ptr<std::pmr::memory_resource>> resources_{};  // Outlives all elements
+};
+
+
+//---- <String.h> ---------------------------------------------------------------------------------
+
+struct String
+{
+ public:
+   String( const char* s )
+      : s_{ s }
+   {}
+
+   String( std::string s )
+      : s_{ std::move(s) }
+   {}
+
+   ~String() = default;
+   String( const String& ) = default;
+   String& operator=( const String& ) = default;
+   String( String&& ) noexcept(true) = default;
+   String& operator=( String&& ) noexcept(true) = default;
+
+   std::size_t size() const noexcept { return s_.size(); }
+
+ private:
+   std::string s_;
+};
+
+
+//---- <Throwing.h> -------------------------------------------------------------------------------
+
+// Element type, whose copy constructor throws on the given number of copies. The number of
+// living instances is tracked to demonstrate the strong exception safety guarantee.
+struct Throwing
+{
+   Throwing() { ++alive; }
+
+   Throwing( Throwing const& )
+   {
+      if( --copies_until_throw == 0 ) {
+         throw std::runtime_error( "Copy failed" );
+      }
+      ++alive;
+   }
+
+   ~Throwing() { --alive; }
+
+   static inline std::atomic<long> alive{ 0L };
+   static inline std::atomic<long> copies_until_throw{ -1L };
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr size_t N( 5000000 );
+
+   const char* const s{ "A long string of 30 characters" };
+
+   std::cout << "\n Serial construction\n";
+
+   std::cout << "  vector::emplace_back():   " << benchmark( [&]{
+      std::vector<String> v;
+      for( size_t i=0UL; i<N; ++i ) {
+         v.emplace_back( s );
+      }
+   } ) << "s\n";
+
+   std::cout << "  vector(n,value):          " << benchmark( [&]{
+      std::vector<String> v( N, String{ s } );
+   } ) << "s\n";
+
+   std::size_t const cores{ std::max( std::thread::hardware_concurrency(), 1U ) };
+
+   std::cout << "\n Bulk construction (" << cores << " hardware threads)\n";
+
+   for( std::size_t threads=1UL; threads<=std::max( cores, std::size_t{8} ); threads*=2UL )
+   {
+      double const global = benchmark( [&]{
+         BulkArray<String> a( N, String{ s }, threads );
+      } );
+
+      double const local = benchmark( [&]{
+         BulkArray<std::pmr::string> a( N, std::pmr::string{ s }, threads );
+      } );
+
+      std::cout << "  " << threads << " thread(s): global allocator " << global
+                << "s, per-thread memory resource " << local << "s\n";
+   }
+
+   std::cout << "\n Strong exception safety\n";
+
+   {
+      Throwing const prototype{};
+      Throwing::copies_until_throw = 1000L;
+
+      try {
+         BulkArray<Throwing> a( 100000UL, prototype, 4UL );
+         std::cerr << "  EXCEPTION NOT PROPAGATED!\n";
+      }
+      catch( std::runtime_error const& ex ) {
+         std::cout << "  Caught '" << ex.what() << "', living instances: "
+                   << Throwing::alive << " (expected 1)\n\n";
+      }
+   }
+
+   return EXIT_SUCCESS;
+}
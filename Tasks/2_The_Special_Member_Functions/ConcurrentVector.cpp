@@ -0,0 +1,299 @@
+/**************************************************************************************************
+*
+* \file ConcurrentVector.cpp
+* \brief C++ Training - Example for a lock-free, append-only vector
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the accumulation of strings by 1 to 64 threads into a mutex-protected
+*       'std::vector' and into a 'ConcurrentVector'. Explain why 'ConcurrentVector' never moves
+*       or copies its elements and why references to its elements stay valid.
+*
+**************************************************************************************************/
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+//---- <ConcurrentVector.h> -----------------------------------------------------------------------
+
+// Append-only vector, which allows an arbitrary number of threads to concurrently add elements.
+// The storage consists of segments of geometrically increasing size, which are allocated on
+// demand and never moved, i.e. references to elements stay valid for the lifetime of the vector.
+// A missing segment is installed via a single compare-and-swap (the losing thread releases its
+// segment again). A slot is reserved via a compare-and-swap on the number of reserved slots, but
+// only once its segment exists: a failing allocation therefore never leaves an empty slot behind,
+// which would block all snapshots (an exception after the reservation marks the slot as failed
+// instead). 'emplace_back()' only has to retry if another thread reserved a slot in the
+// meantime, i.e. some thread always makes progress.
+//
+// Readers must not access elements beyond the size of a snapshot: 'snapshot()' returns the
+// longest prefix of completely constructed elements.
+template< typename T >
+class ConcurrentVector
+{
+ private:
+   enum class State : std::uint8_t { Empty, Ready, Failed };
+
+   struct Slot
+   {
+      std::atomic<State> state{ State::Empty };
+      alignas(T) unsigned char storage[sizeof(T)];
+
+      T*       get()       noexcept { return std::launder( reinterpret_cast<T*>( storage ) ); }
+      T const* get() const noexcept { return std::launder( reinterpret_cast<T const*>( storage ) ); }
+   };
+
+   static constexpr std::size_t first_segment_size{ 64UL };
+   static constexpr std::size_t max_segments{ 48UL };
+
+ public:
+   class Snapshot;
+
+   ConcurrentVector() = default;
+
+   ~ConcurrentVector()
+   {
+      for( std::size_t k=0UL; k<max_segments; ++k ) {
+         Slot* const segment = segments_[k].load( std::memory_order_acquire );
+         if( segment == nullptr ) continue;
+         for( std::size_t i=0UL; i<segment_size( k ); ++i ) {
+            if( segment[i].state.load( std::memory_order_acquire ) == State::Ready ) {
+               std::destroy_at( segment[i].get() );
+            }
+         }
+         delete[] segment;
+      }
+   }
+
+   ConcurrentVector( ConcurrentVector const& ) = delete;
+   ConcurrentVector& operator=( ConcurrentVector const& ) = delete;
+
+   template< typename... Args >
+   T& emplace_back( Args&&... args )
+   {
+      std::size_t index{ reserved_.load( std::memory_order_relaxed ) };
+      do {
+         install_segment( locate( index ).first );
+      } while( !reserved_.compare_exchange_weak( index, index+1UL, std::memory_order_relaxed ) );
+
+      Slot& slot{ slot_at( index ) };
+
+      try {
+         install_next_segment( index );
+         std::construct_at( slot.get(), std::forward<Args>(args)... );
+      }
+      catch( ... ) {
+         slot.state.store( State::Failed, std::memory_order_release );
+         throw;
+      }
+
+      slot.state.store( State::Ready, std::memory_order_release );
+      return *slot.get();
+   }
+
+   T& push_back( T const& value ) { return emplace_back( value ); }
+   T& push_back( T&& value ) { return emplace_back( std::move(value) ); }
+
+   // Number of reserved slots (including elements that are still under construction)
+   std::size_t capacity_used() const noexcept
+   {
+      return reserved_.load( std::memory_order_relaxed );
+   }
+
+   Snapshot snapshot() const;
+
+ private:
+   static constexpr std::size_t segment_size( std::size_t k ) noexcept
+   {
+      return first_segment_size << k;
+   }
+
+   // Segment k holds the elements [first_segment_size*(2^k-1), first_segment_size*(2^(k+1)-1))
+   static constexpr std::pair<std::size_t,std::size_t> locate( std::size_t index ) noexcept
+   {
+      std::size_t const k( std::bit_width( index/first_segment_size + 1UL ) - 1UL );
+      return { k, index - first_segment_size*( ( std::size_t{1} << k ) - 1UL ) };
+   }
+
+   // The thread that reserved the first slot of segment k also installs segment k+1. Thus, the
+   // other threads usually don't race to allocate the same (possibly large) segment.
+   void install_next_segment( std::size_t index ) const
+   {
+      auto const [k, offset] = locate( index );
+      if( offset == 0UL && k+1UL < max_segments ) {
+         install_segment( k+1UL );
+      }
+   }
+
+   // The segment of the given slot must have been installed before
+   Slot& slot_at( std::size_t index ) const noexcept
+   {
+      auto const [k, offset] = locate( index );
+      return segments_[k].load( std::memory_order_acquire )[offset];
+   }
+
+   Slot* install_segment( std::size_t k ) const
+   {
+      Slot* segment = segments_[k].load( std::memory_order_acquire );
+
+      if( segment == nullptr ) {
+         Slot* const fresh = new Slot[segment_size( k )];
+         if( segments_[k].compare_exchange_strong( segment, fresh, std::memory_order_acq_rel ) ) {
+            segment = fresh;
+         }
+         else {
+            delete[] fresh;  // Another thread was faster; 'segment' holds its segment
+         }
+      }
+
+      return segment;
+   }
+
+   bool is_complete( std::size_t index ) const noexcept
+   {
+      auto const [k, offset] = locate( index );
+      Slot const* const segment = segments_[k].load( std::memory_order_acquire );
+      return segment != nullptr &&
+             segment[offset].state.load( std::memory_order_acquire ) != State::Empty;
+   }
+
+   mutable std::array<std::atomic<Slot*>,max_segments> segments_{};
+   std::atomic<std::size_t> reserved_{ 0UL };
+   mutable std::atomic<std::size_t> published_{ 0UL };
+};
+
+
+// Consistent view on the first 'size()' elements of a 'ConcurrentVector'. Elements whose
+// construction failed are skipped during the traversal.
+template< typename T >
+class ConcurrentVector<T>::Snapshot
+{
+ public:
+   std::size_t size() const noexcept { return size_; }
+
+   template< typename Callable >
+   void for_each( Callable callable ) const
+   {
+      for( std::size_t i=0UL; i<size_; ++i ) {
+         Slot const& slot{ vector_->slot_at( i ) };
+         if( slot.state.load( std::memory_order_acquire ) == State::Ready ) {
+            callable( *slot.get() );
+         }
+      }
+   }
+
+ private:
+   friend class ConcurrentVector<T>;
+
+   Snapshot( ConcurrentVector const* vector, std::size_t size )
+      : vector_{ vector }
+      , size_{ size }
+   {}
+
+   ConcurrentVector const* vector_;
+   std::size_t size_;
+};
+
+
+template< typename T >
+typename ConcurrentVector<T>::Snapshot ConcurrentVector<T>::snapshot() const
+{
+   std::size_t const start{ published_.load( std::memory_order_acquire ) };
+   std::size_t const reserved{ reserved_.load( std::memory_order_acquire ) };
+
+   std::size_t size{ start };
+   while( size < reserved && is_complete( size ) ) {
+      ++size;
+   }
+
+   std::size_t expected{ start };
+   while( expected < size &&
+          !published_.compare_exchange_weak( expected, size, std::memory_order_acq_rel ) ) {}
+
+   return Snapshot{ this, size };
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+template< typename Callable >
+double benchmark( std::size_t threads, Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   {
+      std::vector<std::jthread> workers{};
+      for( std::size_t t=0UL; t<threads; ++t ) {
+         workers.emplace_back( callable );
+      }
+   }
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   const size_t N( 1200000UL );
+
+   std::string const s( "A long string with 32 characters" );
+
+   std::cout << "\n Accumulating " << N << " strings\n";
+
+   for( std::size_t threads=1UL; threads<=64UL; threads*=2UL )
+   {
+      std::size_t const n{ N / threads };
+
+      std::vector<std::string> strings{};
+      std::mutex mutex{};
+
+      double const locked = benchmark( threads, [&]{
+         for( size_t i=0UL; i<n; ++i ) {
+            std::scoped_lock lock{ mutex };
+            strings.push_back( s );
+         }
+      } );
+
+      ConcurrentVector<std::string> concurrent{};
+
+      double const lockfree = benchmark( threads, [&]{
+         for( size_t i=0UL; i<n; ++i ) {
+            concurrent.push_back( s );
+         }
+      } );
+
+      std::size_t characters{ 0UL };
+      auto const snapshot = concurrent.snapshot();
+      snapshot.for_each( [&]( std::string const& str ){ characters += str.size(); } );
+
+      std::cout << "  " << threads << " thread(s): mutex+std::vector " << locked
+                << "s, ConcurrentVector " << lockfree << "s"
+                << ( snapshot.size() == strings.size() && characters == strings.size()*s.size()
+                     ? "" : " (SIZE MISMATCH!)" ) << "\n";
+   }
+
+   std::cout << "\n";
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,211 @@
+/**************************************************************************************************
+*
+* \file DefaultInitAllocator.cpp
+* \brief C++ Training - Example for the default initialization of large buffers
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: As in MemberInitialization1-3, examine the difference between default initialization
+*       and value initialization, but for large buffers of 'double' values, which are immediately
+*       overwritten via 'std::iota()' (as in class 'D' in CopyControl.cpp). Compare the runtime
+*       and the number of page faults of the allocation and of the first write access. Note
+*       that the benchmark requires optimizations (e.g. '-O2'), since otherwise the compiler does
+*       not remove the (empty) default initialization loop.
+*
+*       Usage: DefaultInitAllocator [size in MiB, default: 1024]
+*
+**************************************************************************************************/
+
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+
+//---- <DefaultInitAllocator.h> -------------------------------------------------------------------
+
+// Allocator adaptor, which turns the value initialization of elements (e.g. via
+// 'std::vector<T>(n)' or 'std::vector<T>::resize(n)') into a default initialization. For
+// trivial types as 'int' or 'double' this means that the elements are left uninitialized.
+// All other constructions are forwarded to the underlying allocator.
+template< typename T, typename A = std::allocator<T> >
+class default_init_allocator : public A
+{
+ private:
+   using Traits = std::allocator_traits<A>;
+
+ public:
+   template< typename U >
+   struct rebind
+   {
+      using other = default_init_allocator<U,typename Traits::template rebind_alloc<U>>;
+   };
+
+   using A::A;
+
+   template< typename U >
+   void construct( U* ptr ) noexcept( std::is_nothrow_default_constructible_v<U> )
+   {
+      ::new( static_cast<void*>( ptr ) ) U;
+   }
+
+   template< typename U, typename... Args >
+   void construct( U* ptr, Args&&... args )
+   {
+      Traits::construct( static_cast<A&>( *this ), ptr, std::forward<Args>(args)... );
+   }
+};
+
+template< typename T >
+using vector_for_overwrite = std::vector<T,default_init_allocator<T>>;
+
+// Creates a vector of 'n' default initialized elements (uninitialized for trivial types)
+template< typename T >
+vector_for_overwrite<T> make_vector_for_overwrite( std::size_t n )
+{
+   return vector_for_overwrite<T>( n );
+}
+
+
+//---- <D.h> --------------------------------------------------------------------------------------
+
+// Variant of class 'D' from CopyControl.cpp, which avoids the value initialization of the array
+class D
+{
+ public:
+   explicit D( std::size_t n )
+      : n_{ n }
+      , v_{ std::make_unique_for_overwrite<double[]>( n_ ) }
+   {
+      std::iota( v_.get(), v_.get()+n_, 1.0 );
+   }
+
+   double back() const { return v_[n_-1UL]; }
+
+ private:
+   std::size_t n_;
+   std::unique_ptr<double[]> v_;
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+inline long minor_page_faults()
+{
+   rusage usage{};
+   ::getrusage( RUSAGE_SELF, &usage );
+   return usage.ru_minflt;
+}
+
+struct Phase
+{
+   double seconds{};
+   long faults{};
+};
+
+template< typename Callable >
+Phase measure( Callable callable )
+{
+   long const faults{ minor_page_faults() };
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return Phase{ elapsedTime.count(), minor_page_faults() - faults };
+}
+
+// Measures the allocation and the subsequent overwrite of 'n' elements separately
+template< typename Allocate >
+void benchmark( char const* label, std::size_t n, Allocate allocate )
+{
+   decltype( allocate( n ) ) buffer{};
+
+   Phase const alloc = measure( [&]{ buffer = allocate( n ); } );
+   Phase const write = measure( [&]{ std::iota( &buffer[0], &buffer[0]+n, 1.0 ); } );
+
+   std::cout << "  " << label
+             << ": allocation " << alloc.seconds << "s (" << alloc.faults << " page faults)"
+             << ", overwrite " << write.seconds << "s (" << write.faults << " page faults)"
+             << ", total " << alloc.seconds + write.seconds << "s\n";
+}
+
+
+int main( int argc, char** argv )
+{
+   std::size_t mebibytes{ 1024UL };
+
+   if( argc > 1 ) {
+      char* end{ nullptr };
+      errno = 0;
+      mebibytes = std::strtoul( argv[1], &end, 10 );
+      if( argc > 2 || !std::isdigit( static_cast<unsigned char>( argv[1][0] ) ) || *end != '\0' ||
+          errno == ERANGE || mebibytes == 0UL || mebibytes > ( SIZE_MAX >> 20 ) ) {
+         std::cerr << "Usage: " << argv[0] << " [size in MiB, default: 1024]\n";
+         return EXIT_FAILURE;
+      }
+   }
+
+   std::size_t const N{ mebibytes * 1024UL * 1024UL / sizeof(double) };
+
+   std::cout << "\n Allocating and overwriting " << N << " doubles (" << mebibytes << " MiB)\n";
+
+   benchmark( "std::vector<double>(n)         ", N, []( std::size_t n ){
+      return std::vector<double>( n );
+   } );
+
+   benchmark( "make_vector_for_overwrite(n)   ", N, []( std::size_t n ){
+      return make_vector_for_overwrite<double>( n );
+   } );
+
+   benchmark( "std::make_unique<double[]>     ", N, []( std::size_t n ){
+      return std::make_unique<double[]>( n );
+   } );
+
+   benchmark( "std::make_unique_for_overwrite ", N, []( std::size_t n ){
+      return std::make_unique_for_overwrite<double[]>( n );
+   } );
+
+   std::cout << "\n Resizing a vector from 0 to " << N << " doubles\n";
+
+   benchmark( "std::vector<double>::resize    ", N, []( std::size_t n ){
+      std::vector<double> v{};
+      v.resize( n );
+      return v;
+   } );
+
+   benchmark( "vector_for_overwrite::resize   ", N, []( std::size_t n ){
+      vector_for_overwrite<double> v{};
+      v.resize( n );
+      return v;
+   } );
+
+   Phase const d = measure( [&]{
+      D const d( N );
+      if( d.back() != static_cast<double>( N ) ) {
+         std::cerr << " UNEXPECTED VALUE IN D!\n";
+      }
+   } );
+
+   std::cout << "\n Constructing a D of " << N << " doubles: " << d.seconds << "s ("
+             << d.faults << " page faults)\n\n";
+
+   return EXIT_SUCCESS;
+}
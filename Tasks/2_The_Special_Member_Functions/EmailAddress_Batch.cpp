@@ -0,0 +1,407 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Batch.cpp
+* \brief C++ Training - Example for the multi-threaded batch validation of email addresses
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the throughput of the batch validation of a newline-separated and of an
+*       offset-indexed buffer of email addresses for an increasing number of threads with the
+*       construction of one 'EmailAddress' per line. Why doesn't the batch validation have to
+*       create a 'std::string' for invalid addresses?
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   State state{ State::Start };
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return false;
+   }
+   return state == State::Tld;
+}
+
+} // namespace dfa
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   // Tag for addresses that have already been validated; only the 'BatchValidator' can create it
+   class Validated
+   {
+      friend class BatchValidator;
+      Validated() = default;
+   };
+
+   EmailAddress( Validated, std::string_view address )
+      : address_{ address }
+   {}
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::is_email_address( address_ ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <BatchValidator.h> -------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+
+// Dense bitmap with one bit per validated entry
+class ValidityBitmap
+{
+ public:
+   ValidityBitmap() = default;
+   explicit ValidityBitmap( std::size_t size ) : words_( ( size+63UL ) / 64UL ), size_{ size } {}
+
+   std::size_t size() const noexcept { return size_; }
+
+   bool test( std::size_t i ) const noexcept { return ( words_[i/64UL] >> ( i%64UL ) ) & 1U; }
+   void set( std::size_t i ) noexcept { words_[i/64UL] |= std::uint64_t{1} << ( i%64UL ); }
+
+   void push_back( bool bit )
+   {
+      if( size_ % 64UL == 0UL ) words_.push_back( 0U );
+      if( bit ) set( size_ );
+      ++size_;
+   }
+
+   void append( ValidityBitmap const& other )
+   {
+      std::size_t const shift{ size_ % 64UL };
+
+      if( shift == 0UL ) {
+         words_.insert( words_.end(), other.words_.begin(), other.words_.end() );
+      }
+      else {
+         for( std::uint64_t const w : other.words_ ) {
+            words_.back() |= w << shift;
+            words_.push_back( w >> ( 64UL-shift ) );
+         }
+      }
+
+      size_ += other.size_;
+      words_.resize( ( size_+63UL ) / 64UL );
+   }
+
+   std::size_t count() const noexcept
+   {
+      std::size_t n{ 0UL };
+      for( std::uint64_t const w : words_ ) n += std::popcount( w );
+      return n;
+   }
+
+ private:
+   std::vector<std::uint64_t> words_{};
+   std::size_t size_{ 0UL };
+};
+
+
+struct BatchResult
+{
+   ValidityBitmap valid{};
+
+   // The constructed email addresses (if requested), in input order, grouped per thread
+   std::vector<std::vector<EmailAddress>> addresses{};
+
+   template< typename Callable >
+   void for_each_address( Callable callable ) const
+   {
+      for( auto const& chunk : addresses ) {
+         for( auto const& address : chunk ) callable( address );
+      }
+   }
+};
+
+
+// Validates large batches of email addresses by splitting the input into one contiguous part per
+// thread. Invalid entries are only represented by a cleared bit in the resulting bitmap; valid
+// entries can optionally be turned into 'EmailAddress' objects without repeating the validation.
+class BatchValidator
+{
+ public:
+   explicit BatchValidator( std::size_t threads = std::thread::hardware_concurrency() )
+      : threads_{ std::max( threads, std::size_t{1} ) }
+   {}
+
+   // Validates a buffer of newline-separated addresses (a trailing newline is optional)
+   BatchResult validate_lines( std::string_view buffer, bool construct = false ) const
+   {
+      // Splitting the buffer into parts that end directly after a newline
+      std::vector<std::size_t> bounds{ 0UL };
+      for( std::size_t t=1UL; t<threads_; ++t ) {
+         std::size_t pos{ std::max( bounds.back(), buffer.size()*t / threads_ ) };
+         pos = buffer.find( '\n', pos );
+         bounds.push_back( pos == std::string_view::npos ? buffer.size() : pos+1UL );
+      }
+      bounds.push_back( buffer.size() );
+
+      std::vector<ValidityBitmap> bitmaps( threads_ );
+      BatchResult result{};
+      result.addresses.resize( construct ? threads_ : 0UL );
+
+      fork_join( [&]( std::size_t t )
+      {
+         std::string_view part{ buffer.substr( bounds[t], bounds[t+1UL]-bounds[t] ) };
+         while( !part.empty() ) {
+            std::size_t const eol{ std::min( part.find( '\n' ), part.size() ) };
+            std::string_view const line{ part.substr( 0UL, eol ) };
+            bool const valid{ dfa::is_email_address( line ) };
+            bitmaps[t].push_back( valid );
+            if( valid && construct ) {
+               result.addresses[t].emplace_back( EmailAddress::Validated{}, line );
+            }
+            part.remove_prefix( std::min( eol+1UL, part.size() ) );
+         }
+      } );
+
+      result.valid = std::move( bitmaps.front() );
+      for( std::size_t t=1UL; t<threads_; ++t ) {
+         result.valid.append( bitmaps[t] );
+      }
+      return result;
+   }
+
+   // Validates the entries [offsets[i],offsets[i+1]) of the given character blob. Since every
+   // thread validates a multiple of 64 entries, the threads write disjoint words of the bitmap.
+   BatchResult validate_indexed( std::string_view blob, std::span<std::size_t const> offsets,
+                                 bool construct = false ) const
+   {
+      std::size_t const n{ offsets.empty() ? 0UL : offsets.size()-1UL };
+      std::size_t const words{ ( n+63UL ) / 64UL };
+
+      BatchResult result{};
+      result.valid = ValidityBitmap( n );
+      result.addresses.resize( construct ? threads_ : 0UL );
+
+      fork_join( [&]( std::size_t t )
+      {
+         std::size_t const first{ std::min( n, words*t/threads_*64UL ) };
+         std::size_t const last { std::min( n, words*(t+1UL)/threads_*64UL ) };
+
+         for( std::size_t i=first; i<last; ++i ) {
+            std::string_view const entry{ blob.substr( offsets[i], offsets[i+1UL]-offsets[i] ) };
+            if( dfa::is_email_address( entry ) ) {
+               result.valid.set( i );
+               if( construct ) {
+                  result.addresses[t].emplace_back( EmailAddress::Validated{}, entry );
+               }
+            }
+         }
+      } );
+
+      return result;
+   }
+
+ private:
+   template< typename Callable >
+   void fork_join( Callable callable ) const
+   {
+      std::vector<std::jthread> workers{};
+      workers.reserve( threads_-1UL );
+      for( std::size_t t=1UL; t<threads_; ++t ) {
+         workers.emplace_back( callable, t );
+      }
+      callable( 0UL );
+   }
+
+   std::size_t threads_;
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+
+// Creates a buffer of 'n' newline-separated addresses, of which about 30% are invalid
+std::string create_buffer( std::size_t n )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk" };
+   static constexpr char const* defects[] =
+      { "", "", "", "", "", "", "", "..", "@", "-" };
+
+   std::mt19937 rng{ 42U };
+   std::string buffer{};
+   for( std::size_t i=0UL; i<n; ++i ) {
+      buffer += locals[rng()%5U];
+      buffer += std::to_string( rng()%10000U );
+      buffer += defects[rng()%10U];
+      buffer += '@';
+      buffer += domains[rng()%3U];
+      buffer += '\n';
+   }
+   return buffer;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+void report( char const* label, double seconds, std::size_t bytes, std::size_t n, std::size_t valid )
+{
+   std::cout << "  " << label << seconds << "s, " << bytes / seconds / 1e9 << " GB/s, "
+             << n / seconds / 1e6 << "M addresses/s (" << valid << " valid)\n";
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 4000000UL );
+
+   std::string const buffer{ create_buffer( N ) };
+
+   std::vector<std::size_t> offsets{ 0UL };
+   std::string blob{};
+   for( std::size_t pos=0UL; pos<buffer.size(); ) {
+      std::size_t const eol{ buffer.find( '\n', pos ) };
+      blob.append( buffer, pos, eol-pos );
+      offsets.push_back( blob.size() );
+      pos = eol+1UL;
+   }
+
+   std::cout << "\n Validating " << N << " addresses (" << buffer.size() / 1e6 << " MB)\n\n";
+
+   {
+      std::size_t valid{ 0UL };
+      double const seconds = benchmark( [&]{
+         for( std::size_t pos=0UL; pos<buffer.size(); ) {
+            std::size_t const eol{ buffer.find( '\n', pos ) };
+            try {
+               EmailAddress const address{ buffer.substr( pos, eol-pos ) };
+               ++valid;
+            }
+            catch( std::invalid_argument const& ex ) {}
+            pos = eol+1UL;
+         }
+      } );
+      report( "EmailAddress per line:          ", seconds, buffer.size(), N, valid );
+   }
+
+   std::size_t const cores{ std::max( std::thread::hardware_concurrency(), 1U ) };
+
+   for( std::size_t threads=1UL; threads<=std::max( cores, std::size_t{4} ); threads*=2UL )
+   {
+      BatchValidator const validator{ threads };
+      std::cout << "\n " << threads << " thread(s)\n";
+
+      BatchResult lines{};
+      double seconds = benchmark( [&]{ lines = validator.validate_lines( buffer ); } );
+      report( "lines, bitmap only:             ", seconds, buffer.size(), N, lines.valid.count() );
+
+      seconds = benchmark( [&]{ lines = validator.validate_lines( buffer, true ); } );
+      report( "lines, bitmap + EmailAddress:   ", seconds, buffer.size(), N, lines.valid.count() );
+
+      BatchResult indexed{};
+      seconds = benchmark( [&]{ indexed = validator.validate_indexed( blob, offsets ); } );
+      report( "indexed, bitmap only:           ", seconds, blob.size(), N, indexed.valid.count() );
+
+      seconds = benchmark( [&]{ indexed = validator.validate_indexed( blob, offsets, true ); } );
+      report( "indexed, bitmap + EmailAddress: ", seconds, blob.size(), N, indexed.valid.count() );
+
+      std::size_t constructed{ 0UL };
+      indexed.for_each_address( [&]( EmailAddress const& ){ ++constructed; } );
+      if( constructed != indexed.valid.count() || lines.valid.count() != indexed.valid.count() ) {
+         std::cerr << "  INCONSISTENT RESULTS!\n";
+      }
+   }
+
+   std::cout << "\n";
+
+   return EXIT_SUCCESS;
+}
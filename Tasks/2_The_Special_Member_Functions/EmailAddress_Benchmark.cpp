@@ -0,0 +1,675 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Benchmark.cpp
+* \brief C++ Training - Example for a synthetic email address corpus and a validator benchmark
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the throughput of the multi-pass 'is_email_address()' function, the DFA and the
+*       SIMD kernels on generated corpora with different length distributions, domain skews and
+*       error rates. Convince yourself that all validators reject exactly the addresses, which
+*       the generator has broken, and accept all others.
+*
+*       Usage: EmailAddress_Benchmark [<seed>]
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define EMAIL_SIMD_X86 1
+#endif
+
+template< typename RandomAccessIt >
+constexpr bool is_valid_email_part( RandomAccessIt first, RandomAccessIt last )
+{
+   auto const isalnum_or_dots_or_underscore =
+      []( char a ){ return isalnum( static_cast<unsigned char>( a ) ) || a == '.' || a == '_'; };
+
+   auto const adjacent_dots =
+      []( char a, char b ){ return a == '.' && b == '.'; };
+
+   return first != last &&
+          std::all_of( first, last, isalnum_or_dots_or_underscore ) &&
+          std::adjacent_find( first, last, adjacent_dots ) == last &&
+          *first != '.' &&
+          *(last-1) != '.';
+}
+
+template< typename RandomAccessIt >
+constexpr bool is_email_address( RandomAccessIt first, RandomAccessIt last )
+{
+   auto const firstAt = std::find( first, last, '@' );
+   auto const firstDotAfterAt = std::find( firstAt, last, '.' );
+
+   return firstAt != last &&
+          firstDotAfterAt != last &&
+          is_valid_email_part( first, firstAt ) &&
+          is_valid_email_part( firstAt+1, firstDotAfterAt ) &&
+          is_valid_email_part( firstDotAfterAt+1, last );
+
+}
+
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   State state{ State::Start };
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return false;
+   }
+   return state == State::Tld;
+}
+
+} // namespace dfa
+
+
+//---- <EmailAddressSIMD.h> -----------------------------------------------------------------------
+
+namespace simd {
+
+// Classification of a block of 64 characters: bit i of each mask refers to character i
+struct BlockMasks
+{
+   std::uint64_t at;   // '@'
+   std::uint64_t dot;  // '.'
+   std::uint64_t bad;  // Neither alphanumeric nor '.', '_', or '@'
+};
+
+using Classifier = BlockMasks(*)( char const* ) noexcept;
+
+// Validates an email address based on the block classification of the given 'classify' function.
+// The rules of 'is_email_address()' are equivalent to the following conditions:
+//  - the address consists of alphanumeric characters, '.', '_', and exactly one '@';
+//  - the address does not contain two adjacent dots;
+//  - the local part is not empty and neither starts nor ends with a dot;
+//  - there is a dot after the '@', which is neither the first character after the '@' nor the
+//    last character of the address.
+template< Classifier classify >
+inline bool is_email_address( std::string_view address ) noexcept
+{
+   constexpr std::size_t npos{ std::string_view::npos };
+
+   std::size_t const size{ address.size() };
+   std::size_t at{ npos };
+   std::size_t dot{ npos };
+   std::uint64_t previousDot{ 0U };
+
+   alignas(64) char tail[64];
+
+   for( std::size_t base=0UL; base<size; base+=64UL )
+   {
+      std::size_t const remaining{ size - base };
+      BlockMasks m{};
+
+      if( remaining >= 64UL ) {
+         m = classify( address.data()+base );
+      }
+      else {
+         std::memset( tail, 0, sizeof(tail) );
+         std::memcpy( tail, address.data()+base, remaining );
+         m = classify( tail );
+         std::uint64_t const valid{ ( std::uint64_t{1} << remaining ) - 1U };
+         m.at &= valid;
+         m.dot &= valid;
+         m.bad &= valid;
+      }
+
+      if( m.bad != 0U || ( m.dot & ( ( m.dot << 1 ) | previousDot ) ) != 0U ) {
+         return false;
+      }
+      previousDot = m.dot >> 63;
+
+      if( m.at != 0U ) {
+         if( at != npos || ( m.at & ( m.at-1U ) ) != 0U ) {
+            return false;  // More than one '@'
+         }
+         at = base + std::countr_zero( m.at );
+         std::uint64_t const dotsAfterAt{ m.dot & ~( ( m.at << 1 ) - 1U ) };
+         if( dotsAfterAt != 0U ) {
+            dot = base + std::countr_zero( dotsAfterAt );
+         }
+      }
+      else if( at != npos && dot == npos && m.dot != 0U ) {
+         dot = base + std::countr_zero( m.dot );
+      }
+   }
+
+   return at != npos && dot != npos &&
+          at > 0UL && address[0] != '.' && address[at-1UL] != '.' &&
+          dot > at+1UL && dot+1UL < size && address[size-1UL] != '.';
+}
+
+// Scalar classification (for platforms without SIMD support and as reference for the kernels)
+inline BlockMasks classify_scalar( char const* block ) noexcept
+{
+   BlockMasks m{};
+   for( std::size_t i=0UL; i<64UL; ++i ) {
+      unsigned char const c( block[i] );
+      std::uint64_t const bit{ std::uint64_t{1} << i };
+      unsigned char const lower( c | 0x20 );
+      bool const alnum = ( c >= '0' && c <= '9' ) || ( lower >= 'a' && lower <= 'z' );
+      if( c == '@' ) m.at |= bit;
+      if( c == '.' ) m.dot |= bit;
+      if( !alnum && c != '.' && c != '_' && c != '@' ) m.bad |= bit;
+   }
+   return m;
+}
+
+#if EMAIL_SIMD_X86
+
+// SSE2 kernel: 16 characters per instruction; the character ranges are checked via unsigned
+// minimum/maximum comparisons (SSE2 has no unsigned byte comparison)
+inline BlockMasks classify_sse2( char const* block ) noexcept
+{
+   auto const in_range = []( __m128i v, char lo, char hi ) {
+      return _mm_and_si128( _mm_cmpeq_epi8( _mm_max_epu8( v, _mm_set1_epi8( lo ) ), v ),
+                            _mm_cmpeq_epi8( _mm_min_epu8( v, _mm_set1_epi8( hi ) ), v ) );
+   };
+
+   BlockMasks m{};
+
+   for( std::size_t i=0UL; i<4UL; ++i )
+   {
+      __m128i const v = _mm_loadu_si128( reinterpret_cast<__m128i const*>( block + 16UL*i ) );
+
+      __m128i const at    = _mm_cmpeq_epi8( v, _mm_set1_epi8( '@' ) );
+      __m128i const dot   = _mm_cmpeq_epi8( v, _mm_set1_epi8( '.' ) );
+      __m128i const under = _mm_cmpeq_epi8( v, _mm_set1_epi8( '_' ) );
+      __m128i const digit = in_range( v, '0', '9' );
+      __m128i const alpha = in_range( _mm_or_si128( v, _mm_set1_epi8( 0x20 ) ), 'a', 'z' );
+
+      __m128i const good = _mm_or_si128( _mm_or_si128( at, dot ),
+                                         _mm_or_si128( under, _mm_or_si128( digit, alpha ) ) );
+
+      unsigned const shift( 16U*i );
+      m.at  |= std::uint64_t( unsigned( _mm_movemask_epi8( at ) ) ) << shift;
+      m.dot |= std::uint64_t( unsigned( _mm_movemask_epi8( dot ) ) ) << shift;
+      m.bad |= std::uint64_t( unsigned( ~_mm_movemask_epi8( good ) ) & 0xFFFFU ) << shift;
+   }
+
+   return m;
+}
+
+// AVX2 kernel: 32 characters per instruction; the valid characters are classified via two
+// 16-entry lookup tables (indexed by the low and high nibble of each character), which are
+// evaluated via 'vpshufb'. A character is valid if the two table entries share a bit:
+//   bit 0: '.'          (0x2E)          bit 3: 'P'-'Z','p'-'z' (0x50-0x5A, 0x70-0x7A)
+//   bit 1: '0'-'9'      (0x30-0x39)     bit 4: '_'          (0x5F)
+//   bit 2: '@','A'-'O'  (0x40-0x4F)     bit 5: 'a'-'o'      (0x61-0x6F)
+__attribute__(( target( "avx2" ) ))
+inline BlockMasks classify_avx2( char const* block ) noexcept
+{
+   __m256i const lo_table = _mm256_setr_epi8(
+      0x0E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2C,0x24,0x24,0x24,0x25,0x34,
+      0x0E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2C,0x24,0x24,0x24,0x25,0x34 );
+   __m256i const hi_table = _mm256_setr_epi8(
+      0x00,0x00,0x01,0x02,0x04,0x18,0x20,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+      0x00,0x00,0x01,0x02,0x04,0x18,0x20,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 );
+   __m256i const nibble = _mm256_set1_epi8( 0x0F );
+
+   BlockMasks m{};
+
+   for( std::size_t i=0UL; i<2UL; ++i )
+   {
+      __m256i const v = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( block + 32UL*i ) );
+
+      __m256i const lo = _mm256_shuffle_epi8( lo_table, _mm256_and_si256( v, nibble ) );
+      __m256i const hi = _mm256_shuffle_epi8( hi_table,
+                            _mm256_and_si256( _mm256_srli_epi16( v, 4 ), nibble ) );
+      __m256i const bad = _mm256_cmpeq_epi8( _mm256_and_si256( lo, hi ), _mm256_setzero_si256() );
+
+      __m256i const at  = _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '@' ) );
+      __m256i const dot = _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '.' ) );
+
+      unsigned const shift( 32U*i );
+      m.at  |= std::uint64_t( unsigned( _mm256_movemask_epi8( at ) ) ) << shift;
+      m.dot |= std::uint64_t( unsigned( _mm256_movemask_epi8( dot ) ) ) << shift;
+      m.bad |= std::uint64_t( unsigned( _mm256_movemask_epi8( bad ) ) ) << shift;
+   }
+
+   return m;
+}
+
+__attribute__(( target( "avx2" ) ))
+inline bool is_email_address_avx2( std::string_view address ) noexcept
+{
+   return is_email_address<classify_avx2>( address );
+}
+
+inline bool is_email_address_sse2( std::string_view address ) noexcept
+{
+   return is_email_address<classify_sse2>( address );
+}
+
+#endif
+
+inline bool is_email_address_scalar( std::string_view address ) noexcept
+{
+   return is_email_address<classify_scalar>( address );
+}
+
+using Kernel = bool(*)( std::string_view ) noexcept;
+
+// Selects the best available kernel at runtime, based on the features of the CPU
+inline Kernel select_kernel() noexcept
+{
+#if EMAIL_SIMD_X86
+   __builtin_cpu_init();
+   if( __builtin_cpu_supports( "avx2" ) ) {
+      return is_email_address_avx2;
+   }
+   return is_email_address_sse2;
+#else
+   return is_email_address_scalar;
+#endif
+}
+
+inline bool is_email_address( std::string_view address ) noexcept
+{
+   static Kernel const kernel{ select_kernel() };
+   return kernel( address );
+}
+
+} // namespace simd
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::is_email_address( address_ ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <CorpusGenerator.h> ------------------------------------------------------------------------
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Defects, which the generator injects into otherwise valid addresses. Every defect violates
+// exactly one rule of 'is_email_address()' and 'is_valid_email_part()'.
+enum class Defect : std::uint8_t
+{
+   None,
+   MissingAt,         // No '@' at all
+   MultipleAt,        // A second '@'
+   MissingDot,        // No dot after the '@'
+   EmptyLocalPart,    // Nothing in front of the '@'
+   EmptyDomain,       // A dot directly after the '@'
+   EmptyTld,          // Nothing after the first dot after the '@', e.g. "klaus@gmx."
+   InvalidCharacter,  // A character, which is neither alphanumeric nor '.', '_' or '@'
+   LeadingDot,        // A dot at the beginning of the local part
+   TrailingDot,       // A dot at the end of the local part
+   AdjacentDots       // Two adjacent dots after the first dot after the '@', e.g. "klaus@gmx.d..e"
+};
+
+inline constexpr std::size_t defect_count{ 11UL };
+
+constexpr char const* to_string( Defect defect ) noexcept
+{
+   constexpr char const* names[defect_count] =
+      { "None", "MissingAt", "MultipleAt", "MissingDot", "EmptyLocalPart", "EmptyDomain",
+        "EmptyTld", "InvalidCharacter", "LeadingDot", "TrailingDot", "AdjacentDots" };
+   return names[std::size_t(defect)];
+}
+
+struct CorpusConfig
+{
+   std::uint32_t seed{ 42U };
+   double invalid_ratio{ 0.1 };       // Fraction of addresses with a defect
+   std::size_t domains{ 1000UL };     // Number of different domains
+   double domain_skew{ 1.0 };         // Exponent of the Zipf distribution of the domains
+   double mean_local_length{ 10.0 };  // Mean length of the local part (log-normal distribution)
+   std::size_t max_local_length{ 64UL };
+};
+
+struct Sample
+{
+   std::string address;
+   Defect defect;
+};
+
+// Deterministic generator of email addresses: the same configuration (including the seed)
+// always yields the same sequence of addresses
+class CorpusGenerator
+{
+ public:
+   explicit CorpusGenerator( CorpusConfig const& config )
+      : config_( config )
+      , rng_( config.seed )
+      , local_length_( std::log( config.mean_local_length ) - 0.125, 0.5 )
+   {
+      std::vector<double> weights( config.domains );
+      for( std::size_t i=0UL; i<config.domains; ++i ) {
+         weights[i] = 1.0 / std::pow( double( i+1UL ), config.domain_skew );
+      }
+      domain_ = std::discrete_distribution<std::size_t>( weights.begin(), weights.end() );
+
+      domains_.reserve( config.domains );
+      for( std::size_t i=0UL; i<config.domains; ++i ) {
+         domains_.push_back( create_domain() );
+      }
+   }
+
+   Sample next()
+   {
+      std::string local{ create_local_part() };
+      std::string domain{ domains_[domain_( rng_ )] };
+
+      Defect defect{ Defect::None };
+      if( std::uniform_real_distribution<double>{}( rng_ ) < config_.invalid_ratio ) {
+         defect = static_cast<Defect>( 1UL + rng_() % ( defect_count-1UL ) );
+      }
+
+      switch( defect ) {
+         case Defect::None:           break;
+         case Defect::MissingAt:      return { local + domain, defect };
+         case Defect::MultipleAt:     domain.insert( pick( domain.size()+1UL ), 1UL, '@' ); break;
+         case Defect::MissingDot:     domain.erase( domain.find( '.' ) ); break;
+         case Defect::EmptyLocalPart: local.clear(); break;
+         case Defect::EmptyDomain:    domain.insert( 0UL, 1UL, '.' ); break;
+         case Defect::EmptyTld:       domain.erase( domain.find( '.' )+1UL ); break;
+         case Defect::InvalidCharacter: {
+            static constexpr char invalid[] = "-+ !#$%&*/=?^{|}~\"(),:;<>[\\]\x80\xC3\xFF";
+            local[pick( local.size() )] = invalid[pick( sizeof(invalid)-1UL )];
+            break;
+         }
+         case Defect::LeadingDot:     local.insert( 0UL, 1UL, '.' ); break;
+         case Defect::TrailingDot:    local += '.'; break;
+         case Defect::AdjacentDots:   domain.insert( domain.find( '.' )+2UL, ".." ); break;
+      }
+
+      return { local + '@' + domain, defect };
+   }
+
+   std::vector<Sample> generate( std::size_t n )
+   {
+      std::vector<Sample> samples{};
+      samples.reserve( n );
+      for( std::size_t i=0UL; i<n; ++i ) {
+         samples.push_back( next() );
+      }
+      return samples;
+   }
+
+ private:
+   std::size_t pick( std::size_t n ) { return rng_() % n; }
+
+   char word_character()
+   {
+      static constexpr char characters[] =
+         "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz"
+         "0123456789_ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+      return characters[pick( sizeof(characters)-1UL )];
+   }
+
+   // Word characters with single dots in between, e.g. "klaus.iglberger"
+   std::string create_local_part()
+   {
+      auto const length = std::clamp<std::size_t>(
+         static_cast<std::size_t>( std::lround( local_length_( rng_ ) ) ), 1UL,
+         config_.max_local_length );
+
+      std::string local( length, ' ' );
+      for( std::size_t i=0UL; i<length; ++i ) {
+         bool const dot{ i > 0UL && i+1UL < length && local[i-1UL] != '.' && pick( 8UL ) == 0UL };
+         local[i] = dot ? '.' : word_character();
+      }
+      return local;
+   }
+
+   // One to three lower-case labels and a top-level domain, e.g. "mail.server.co.uk"
+   std::string create_domain()
+   {
+      static constexpr char const* tlds[] = { "com", "de", "org", "net", "co.uk", "info", "io" };
+
+      std::string domain{};
+      std::size_t const labels{ 1UL + pick( 3UL ) };
+      for( std::size_t l=0UL; l<labels; ++l ) {
+         std::size_t const length{ 2UL + pick( 11UL ) };
+         for( std::size_t i=0UL; i<length; ++i ) {
+            domain += static_cast<char>( 'a' + pick( 26UL ) );
+         }
+         domain += '.';
+      }
+      return domain + tlds[pick( 7UL )];
+   }
+
+   CorpusConfig config_;
+   std::mt19937 rng_;
+   std::lognormal_distribution<double> local_length_;
+   std::discrete_distribution<std::size_t> domain_{};
+   std::vector<std::string> domains_{};
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <CorpusGenerator.h>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+
+using Validator = bool(*)( std::string_view );
+
+struct Implementation
+{
+   char const* name;
+   Validator validate;
+};
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+// Reports the number of addresses and of bytes per second for every implementation
+void run( char const* name, std::vector<Sample> const& samples,
+          std::vector<Implementation> const& implementations )
+{
+   constexpr std::size_t repetitions{ 5UL };
+
+   std::size_t bytes{ 0UL };
+   for( auto const& s : samples ) bytes += s.address.size();
+
+   std::cout << "\n " << name << " (" << samples.size() << " addresses, "
+             << double( bytes ) / double( samples.size() ) << " bytes on average)\n";
+
+   for( Implementation const& impl : implementations )
+   {
+      std::size_t valid{ 0UL };
+      double const seconds = benchmark( [&]{
+         for( std::size_t r=0UL; r<repetitions; ++r ) {
+            for( auto const& s : samples ) {
+               valid += impl.validate( s.address );
+            }
+         }
+      } );
+
+      std::cout << "  " << std::left << std::setw(20) << impl.name << std::right
+                << std::setw(8) << std::setprecision(4)
+                << double( samples.size()*repetitions ) / seconds / 1e6 << " M addresses/s"
+                << std::setw(8) << double( bytes*repetitions ) / seconds / 1e6 << " MB/s ("
+                << valid/repetitions << " valid)\n";
+   }
+}
+
+// Checks that every implementation accepts exactly the addresses without defect
+std::size_t cross_check( std::vector<Sample> const& samples,
+                         std::vector<Implementation> const& implementations )
+{
+   std::size_t mismatches{ 0UL };
+   for( auto const& s : samples ) {
+      for( Implementation const& impl : implementations ) {
+         if( impl.validate( s.address ) != ( s.defect == Defect::None ) ) {
+            if( mismatches++ < 10UL ) {
+               std::cerr << "  " << impl.name << " disagrees on '" << s.address << "' ("
+                         << to_string( s.defect ) << ")\n";
+            }
+         }
+      }
+   }
+   return mismatches;
+}
+
+
+int main( int argc, char** argv )
+{
+   constexpr std::size_t N( 1000000UL );
+
+   if( argc > 2 ) {
+      std::cerr << "Usage: " << argv[0] << " [<seed>]\n";
+      return EXIT_FAILURE;
+   }
+   auto const seed =
+      static_cast<std::uint32_t>( argc == 2 ? std::strtoul( argv[1], nullptr, 10 ) : 42UL );
+
+   std::vector<Implementation> const implementations{
+      { "is_email_address()",
+        []( std::string_view a ){ return ::is_email_address( a.begin(), a.end() ); } },
+      { "DFA",
+        []( std::string_view a ){ return dfa::is_email_address( a ); } },
+      { "SIMD scalar blocks",
+        []( std::string_view a ){ return simd::is_email_address_scalar( a ); } },
+#if EMAIL_SIMD_X86
+      { "SIMD SSE2",
+        []( std::string_view a ){ return simd::is_email_address_sse2( a ); } },
+#endif
+      { "SIMD dispatch",
+        []( std::string_view a ){ return simd::is_email_address( a ); } }
+   };
+
+   struct Corpus
+   {
+      char const* name;
+      CorpusConfig config;
+   };
+
+   std::vector<Corpus> const corpora{
+      { "Realistic: 10% invalid, Zipf domains", { seed, 0.1, 1000UL, 1.0, 10.0, 64UL } },
+      { "All valid, uniform domains",          { seed, 0.0, 1000UL, 0.0, 10.0, 64UL } },
+      { "Long local parts (mean 40)",          { seed, 0.1, 1000UL, 1.0, 40.0, 200UL } },
+      { "All invalid",                         { seed, 1.0, 1000UL, 1.0, 10.0, 64UL } }
+   };
+
+   std::cout << "\n Seed " << seed << ", one address per defect:\n";
+   {
+      std::array<bool,defect_count> shown{};
+      CorpusGenerator generator{ CorpusConfig{ seed, 0.5 } };
+      for( std::size_t found=0UL; found<defect_count; ) {
+         Sample const s{ generator.next() };
+         if( !std::exchange( shown[std::size_t(s.defect)], true ) ) {
+            std::cout << "  " << std::left << std::setw(18) << to_string( s.defect ) << std::right
+                      << s.address << "\n";
+            ++found;
+         }
+      }
+   }
+
+   std::size_t mismatches{ 0UL };
+   for( Corpus const& corpus : corpora ) {
+      std::vector<Sample> const samples{ CorpusGenerator{ corpus.config }.generate( N ) };
+      mismatches += cross_check( samples, implementations );
+      run( corpus.name, samples, implementations );
+   }
+
+   std::cout << "\n Cross-check: " << mismatches << " mismatches\n\n";
+   if( mismatches != 0UL ) {
+      std::cerr << " VALIDATORS DISAGREE WITH THE GENERATOR!\n";
+      return EXIT_FAILURE;
+   }
+
+   return EXIT_SUCCESS;
+}
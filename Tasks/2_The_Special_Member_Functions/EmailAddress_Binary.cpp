@@ -0,0 +1,581 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Binary.cpp
+* \brief C++ Training - Example for a binary file format of pre-validated email addresses (POSIX)
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the startup time of a service, which re-parses and re-validates a text file of
+*       email addresses, with the startup time of a service, which maps a binary file of already
+*       validated addresses into memory. Compare both with a cold and with a warm page cache.
+*       Which work does the binary format avoid, and what does the checksum protect against?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+struct Result
+{
+   bool valid{ false };
+   std::size_t at{ 0UL };       // Position of the '@'
+   std::size_t dot{ 0UL };      // Position of the last dot (i.e. the dot in front of the TLD)
+   std::uint64_t hash{ 0U };
+};
+
+// Validates the given address in a single pass, records the position of the '@' and of the
+// last dot (see EmailAddress_Split.cpp) and computes the hash of the address. The hash is part
+// of the file format below: it is a case-sensitive FNV-1a hash of all characters with a short
+// finalizer, which differs from the hash in EmailAddress_Hash.cpp and must not be changed
+// without a new format version.
+constexpr Result validate( std::string_view address ) noexcept
+{
+   Result result{};
+   std::uint64_t hash{ 14695981039346656037ULL };
+   State state{ State::Start };
+
+   for( std::size_t i=0UL; i<address.size(); ++i )
+   {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( address[i] )])];
+
+      if( state == State::Reject ) {
+         return result;
+      }
+      if( state == State::At ) {
+         result.at = i;
+      }
+      else if( state == State::TldStart ) {
+         result.dot = i;
+      }
+      hash = ( hash ^ static_cast<unsigned char>( address[i] ) ) * 1099511628211ULL;
+   }
+
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+
+   result.valid = ( state == State::Tld );
+   result.hash = hash;
+   return result;
+}
+
+} // namespace dfa
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( address_.size() > std::numeric_limits<std::uint16_t>::max() ) {
+         throw std::invalid_argument( "Email address too long" );
+      }
+
+      dfa::Result const result{ dfa::validate( address_ ) };
+      if( !result.valid ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+
+      at_   = static_cast<std::uint16_t>( result.at );
+      dot_  = static_cast<std::uint16_t>( result.dot );
+      hash_ = result.hash;
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::validate( address_ ).valid; }
+
+   std::uint16_t at() const noexcept { return at_; }
+   std::uint16_t dot() const noexcept { return dot_; }
+   std::uint64_t hash() const noexcept { return hash_; }
+
+   std::string_view tld() const noexcept
+   {
+      return std::string_view{ address_ }.substr( dot_+1UL );
+   }
+
+ private:
+   std::string address_;
+   std::uint16_t at_{};   // Position of the '@'
+   std::uint16_t dot_{};  // Position of the dot in front of the top-level domain
+   std::uint64_t hash_{};
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <MappedFile.h> -----------------------------------------------------------------------------
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mapping of an entire file (see EmailAddress_Mmap.cpp)
+class MappedFile
+{
+ public:
+   explicit MappedFile( std::string const& path )
+   {
+      int const fd = ::open( path.c_str(), O_RDONLY );
+      if( fd < 0 ) {
+         throw std::system_error( errno, std::generic_category(), "Cannot open '" + path + "'" );
+      }
+
+      struct stat info{};
+      if( ::fstat( fd, &info ) != 0 ) {
+         int const error{ errno };
+         ::close( fd );
+         throw std::system_error( error, std::generic_category(), "Cannot stat '" + path + "'" );
+      }
+
+      size_ = static_cast<std::size_t>( info.st_size );
+
+      if( size_ > 0UL ) {
+         void* const ptr = ::mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+         if( ptr == MAP_FAILED ) {
+            int const error{ errno };
+            ::close( fd );
+            throw std::system_error( error, std::generic_category(), "Cannot map '" + path + "'" );
+         }
+         data_ = static_cast<char const*>( ptr );
+      }
+
+      ::close( fd );  // The mapping stays valid after closing the file descriptor
+   }
+
+   ~MappedFile()
+   {
+      if( data_ != nullptr ) {
+         ::munmap( const_cast<char*>( data_ ), size_ );
+      }
+   }
+
+   MappedFile( MappedFile const& ) = delete;
+   MappedFile& operator=( MappedFile const& ) = delete;
+
+   std::string_view view() const noexcept { return { data_, size_ }; }
+
+ private:
+   char const* data_{ nullptr };
+   std::size_t size_{ 0UL };
+};
+
+
+//---- <AddressFile.h> ----------------------------------------------------------------------------
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <span>
+
+// File format (version 1, all integers in little-endian byte order):
+//
+//    Header     magic "EMLADDR", version, count, blob size, checksum    40 bytes
+//    Offsets    begin of every address in the blob, plus the end       (count+1) * 8 bytes
+//    Hashes     hash of every address (see 'dfa::validate()')          count * 8 bytes
+//    Positions  position of the '@' and of the last dot                count * 4 bytes
+//    Blob       characters of all addresses, without separators        blob size bytes
+//
+// The checksum covers everything after the header. Only validated addresses are written.
+namespace format {
+
+static_assert( std::endian::native == std::endian::little,
+               "The file format is only implemented for little-endian platforms" );
+
+inline constexpr char magic[8]{ 'E', 'M', 'L', 'A', 'D', 'D', 'R', '\0' };
+inline constexpr std::uint32_t version{ 1U };
+
+struct Header
+{
+   char magic[8];
+   std::uint32_t version;
+   std::uint32_t reserved;
+   std::uint64_t count;
+   std::uint64_t blob_size;
+   std::uint64_t checksum;
+};
+
+struct Positions
+{
+   std::uint16_t at;
+   std::uint16_t dot;
+};
+
+static_assert( sizeof(Header) == 40UL && sizeof(Positions) == 4UL );
+
+// Processes 8 bytes per step (and the remaining bytes at the end)
+inline std::uint64_t checksum( std::string_view data ) noexcept
+{
+   std::uint64_t h{ 0x9e3779b97f4a7c15ULL ^ data.size() };
+   std::size_t i{ 0UL };
+   for( ; i+8UL<=data.size(); i+=8UL ) {
+      std::uint64_t word;
+      std::memcpy( &word, data.data()+i, 8UL );
+      h = std::rotl( h ^ ( word * 0x87c37b91114253d5ULL ), 31 ) * 0x4cf5ad432745937fULL;
+   }
+   for( ; i<data.size(); ++i ) {
+      h = ( h ^ static_cast<unsigned char>( data[i] ) ) * 0x100000001b3ULL;
+   }
+   return h ^ ( h >> 29 );
+}
+
+// Reads a (possibly unaligned) value of type T
+template< typename T >
+T load( char const* ptr ) noexcept
+{
+   T value;
+   std::memcpy( &value, ptr, sizeof(T) );
+   return value;
+}
+
+} // namespace format
+
+
+// Non-owning view of an address in an 'AddressFile'. Since only validated addresses are
+// written, a view is created without re-validation.
+class EmailAddressView
+{
+ public:
+   std::string_view value() const noexcept { return address_; }
+   bool is_valid() const noexcept { return dfa::validate( address_ ).valid; }
+   std::uint64_t hash() const noexcept { return hash_; }
+
+   std::string_view local_part() const noexcept { return address_.substr( 0UL, at_ ); }
+   std::string_view domain() const noexcept { return address_.substr( at_+1UL ); }
+   std::string_view tld() const noexcept { return address_.substr( dot_+1UL ); }
+
+ private:
+   friend class AddressFile;
+
+   EmailAddressView( std::string_view address, format::Positions positions,
+                     std::uint64_t hash ) noexcept
+      : address_{ address }
+      , hash_{ hash }
+      , at_{ positions.at }
+      , dot_{ positions.dot }
+   {}
+
+   std::string_view address_;
+   std::uint64_t hash_;
+   std::uint16_t at_;
+   std::uint16_t dot_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddressView const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+// Writes the given addresses in the binary format
+void write_address_file( std::string const& path, std::span<EmailAddress const> addresses )
+{
+   std::size_t blob_size{ 0UL };
+   for( auto const& a : addresses ) blob_size += a.value().size();
+
+   std::size_t const count{ addresses.size() };
+   std::string payload( (count+1UL)*8UL + count*8UL + count*4UL + blob_size, '\0' );
+
+   char* offsets  { payload.data() };
+   char* hashes   { offsets + (count+1UL)*8UL };
+   char* positions{ hashes + count*8UL };
+   char* blob     { positions + count*4UL };
+
+   std::uint64_t offset{ 0U };
+   for( std::size_t i=0UL; i<count; ++i ) {
+      EmailAddress const& a{ addresses[i] };
+      std::uint64_t const hash{ a.hash() };
+      format::Positions const pos{ a.at(), a.dot() };
+
+      std::memcpy( offsets+i*8UL, &offset, 8UL );
+      std::memcpy( hashes+i*8UL, &hash, 8UL );
+      std::memcpy( positions+i*4UL, &pos, 4UL );
+      std::memcpy( blob+offset, a.value().data(), a.value().size() );
+      offset += a.value().size();
+   }
+   std::memcpy( offsets+count*8UL, &offset, 8UL );
+
+   format::Header header{};
+   std::memcpy( header.magic, format::magic, sizeof(header.magic) );
+   header.version   = format::version;
+   header.count     = count;
+   header.blob_size = blob_size;
+   header.checksum  = format::checksum( payload );
+
+   std::ofstream file{ path, std::ios::binary };
+   file.write( reinterpret_cast<char const*>( &header ), sizeof(header) );
+   file.write( payload.data(), static_cast<std::streamsize>( payload.size() ) );
+   if( !file ) {
+      throw std::runtime_error( "Cannot write '" + path + "'" );
+   }
+}
+
+
+// Memory-mapped file of validated addresses. The header, the size of all sections and the
+// checksum are verified on construction; the addresses themselves are not re-validated. Note
+// that the checksum protects against truncated and corrupted files, not against deliberately
+// crafted ones.
+class AddressFile
+{
+ public:
+   explicit AddressFile( std::string const& path )
+      : file_{ path }
+   {
+      std::string_view const data{ file_.view() };
+      if( data.size() < sizeof(format::Header) ) {
+         throw std::runtime_error( "'" + path + "' is not an address file" );
+      }
+
+      auto const header = format::load<format::Header>( data.data() );
+      if( std::memcmp( header.magic, format::magic, sizeof(header.magic) ) != 0 ) {
+         throw std::runtime_error( "'" + path + "' is not an address file" );
+      }
+      if( header.version != format::version ) {
+         throw std::runtime_error( "Unsupported version " + std::to_string( header.version ) +
+                                   " of '" + path + "'" );
+      }
+
+      std::string_view const payload{ data.substr( sizeof(format::Header) ) };
+      if( header.count > payload.size() / 20UL ||
+          payload.size() != (header.count+1UL)*8UL + header.count*12UL + header.blob_size ) {
+         throw std::runtime_error( "Truncated address file '" + path + "'" );
+      }
+      if( format::checksum( payload ) != header.checksum ) {
+         throw std::runtime_error( "Checksum mismatch in '" + path + "'" );
+      }
+
+      count_     = header.count;
+      offsets_   = payload.data();
+      hashes_    = offsets_ + (count_+1UL)*8UL;
+      positions_ = hashes_ + count_*8UL;
+      blob_      = positions_ + count_*4UL;
+   }
+
+   std::size_t size() const noexcept { return count_; }
+
+   EmailAddressView operator[]( std::size_t i ) const noexcept
+   {
+      auto const begin = format::load<std::uint64_t>( offsets_ + i*8UL );
+      auto const end   = format::load<std::uint64_t>( offsets_ + (i+1UL)*8UL );
+      return EmailAddressView{ std::string_view( blob_+begin, end-begin ),
+                               format::load<format::Positions>( positions_ + i*4UL ),
+                               format::load<std::uint64_t>( hashes_ + i*8UL ) };
+   }
+
+ private:
+   MappedFile file_;
+   std::size_t count_{ 0UL };
+   char const* offsets_{ nullptr };
+   char const* hashes_{ nullptr };
+   char const* positions_{ nullptr };
+   char const* blob_{ nullptr };
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <MappedFile.h>
+//#include <AddressFile.h>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+std::vector<EmailAddress> create_addresses( std::size_t n )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk" };
+
+   std::mt19937 rng{ 42U };
+   std::vector<EmailAddress> addresses{};
+   addresses.reserve( n );
+   for( std::size_t i=0UL; i<n; ++i ) {
+      addresses.emplace_back( std::string{ locals[rng()%5U] } + std::to_string( rng()%10000U ) +
+                              '@' + domains[rng()%3U] );
+   }
+   return addresses;
+}
+
+// Creates an empty file with a unique name in the temporary directory and returns its path
+std::string create_temporary_file( std::string const& stem )
+{
+   std::string path{ ( std::filesystem::temp_directory_path() / ( stem + "_XXXXXX" ) ).string() };
+   int const fd{ ::mkstemp( path.data() ) };
+   if( fd == -1 ) {
+      throw std::system_error( errno, std::generic_category(), "Cannot create '" + path + "'" );
+   }
+   ::close( fd );
+   return path;
+}
+
+// Evicts the given file from the page cache, such that the next access reads from disk
+void drop_page_cache( std::string const& path )
+{
+   int const fd = ::open( path.c_str(), O_RDONLY );
+   if( fd < 0 ) {
+      throw std::system_error( errno, std::generic_category(), "Cannot open '" + path + "'" );
+   }
+   ::fdatasync( fd );
+   ::posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+   ::close( fd );
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 5000000UL );
+
+   std::string text_path{}, binary_path{};
+
+   try {
+      text_path = create_temporary_file( "email_addresses_txt" );
+      binary_path = create_temporary_file( "email_addresses_bin" );
+
+      {
+         std::vector<EmailAddress> const addresses{ create_addresses( N ) };
+         std::ofstream text{ text_path };
+         for( auto const& a : addresses ) text << a.value() << '\n';
+         text.close();
+         write_address_file( binary_path, addresses );
+      }
+
+      // Startup: making all addresses available and counting the German addresses once
+      std::size_t german1{ 0UL }, german2{ 0UL };
+
+      auto const reparse = [&]{
+         std::vector<EmailAddress> addresses{};
+         std::ifstream file{ text_path };
+         for( std::string line; std::getline( file, line ); ) {
+            addresses.emplace_back( line );
+         }
+         german1 = std::count_if( addresses.begin(), addresses.end(),
+                                  []( EmailAddress const& a ){ return a.tld() == "de"; } );
+      };
+
+      auto const reload = [&]{
+         AddressFile const file{ binary_path };
+         german2 = 0UL;
+         for( std::size_t i=0UL; i<file.size(); ++i ) {
+            german2 += ( file[i].tld() == "de" );
+         }
+      };
+
+      drop_page_cache( text_path );
+      double const cold_text = benchmark( reparse );
+      double const warm_text = benchmark( reparse );
+
+      drop_page_cache( binary_path );
+      double const cold_binary = benchmark( reload );
+      double const warm_binary = benchmark( reload );
+
+      AddressFile const file{ binary_path };
+
+      std::cout << "\n Email address: " << file[0] << "\n"
+                << "\n Startup with " << N << " addresses ("
+                << std::filesystem::file_size( text_path ) / 1e6 << " MB text, "
+                << std::filesystem::file_size( binary_path ) / 1e6 << " MB binary)\n"
+                << "                       cold         warm\n"
+                << "  Text re-parsing:     " << cold_text   << "s    " << warm_text   << "s\n"
+                << "  Binary mmap():       " << cold_binary << "s    " << warm_binary << "s\n\n";
+
+      if( german1 != german2 ) {
+         std::cerr << " RESULTS DIFFER!\n";
+      }
+   }
+   catch( std::exception const& ex ) {
+      std::cerr << ex.what() << "\n";
+      if( !text_path.empty() ) std::filesystem::remove( text_path );
+      if( !binary_path.empty() ) std::filesystem::remove( binary_path );
+      return EXIT_FAILURE;
+   }
+
+   std::filesystem::remove( text_path );
+   std::filesystem::remove( binary_path );
+
+   return EXIT_SUCCESS;
+}
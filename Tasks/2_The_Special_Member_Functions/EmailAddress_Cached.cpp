@@ -0,0 +1,215 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Cached.cpp
+* \brief C++ Training - Example for caching the validity of an email address
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the runtime of printing 1 million email addresses to a null stream with and
+*       without a cached validity flag. Which state does a moved-from 'EmailAddress' have and how
+*       is it reflected by 'is_valid()'?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+template< typename RandomAccessIt >
+constexpr bool is_valid_email_part( RandomAccessIt first, RandomAccessIt last )
+{
+   auto const isalnum_or_dots_or_underscore =
+      []( char a ){ return isalnum(a) || a == '.' || a == '_'; };
+
+   auto const adjacent_dots =
+      []( char a, char b ){ return a == '.' && b == '.'; };
+
+   return first != last &&
+          std::all_of( first, last, isalnum_or_dots_or_underscore ) &&
+          std::adjacent_find( first, last, adjacent_dots ) == last &&
+          *first != '.' &&
+          *(last-1) != '.';
+}
+
+template< typename RandomAccessIt >
+constexpr bool is_email_address( RandomAccessIt first, RandomAccessIt last )
+{
+   auto const firstAt = std::find( first, last, '@' );
+   auto const firstDotAfterAt = std::find( firstAt, last, '.' );
+
+   return firstAt != last &&
+          firstDotAfterAt != last &&
+          is_valid_email_part( first, firstAt ) &&
+          is_valid_email_part( firstAt+1, firstDotAfterAt ) &&
+          is_valid_email_part( firstDotAfterAt+1, last );
+
+}
+
+// Email address, which validates its address exactly once. Since the validity is stored
+// alongside the address, 'EmailAddress' can be cheaply moved: the moved-from object is empty
+// and reports to be invalid, without rescanning the address.
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+      , valid_{ is_email_address( begin(address_), end(address_) ) }
+   {
+      if( !valid_ ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+
+   EmailAddress( EmailAddress&& other ) noexcept
+      : address_{ std::exchange( other.address_, {} ) }
+      , valid_{ std::exchange( other.valid_, false ) }
+   {}
+
+   EmailAddress& operator=( EmailAddress&& other ) noexcept
+   {
+      address_ = std::exchange( other.address_, {} );  // Safe for self-assignment
+      valid_ = std::exchange( other.valid_, false );
+      return *this;
+   }
+
+   std::string const& value() const noexcept { return address_; }
+   bool is_valid() const noexcept { return valid_; }
+
+   // Only the characters are compared, since two equal addresses have the same validity
+   friend bool operator==( EmailAddress const& lhs, EmailAddress const& rhs ) noexcept
+   {
+      return lhs.address_ == rhs.address_;
+   }
+
+   friend auto operator<=>( EmailAddress const& lhs, EmailAddress const& rhs ) noexcept
+   {
+      return lhs.address_ <=> rhs.address_;
+   }
+
+ private:
+   std::string address_;
+   bool valid_;  // Valid after successful construction, invalid after a move
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <vector>
+
+
+// Reference: the email address of the solution, which rescans the address in 'is_valid()'
+class RescanningEmailAddress
+{
+ public:
+   explicit RescanningEmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return is_email_address( begin(address_), end(address_) ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, RescanningEmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+// Stream buffer, which discards all characters
+class NullBuffer : public std::streambuf
+{
+ protected:
+   int overflow( int c ) override { return c; }
+   std::streamsize xsputn( char const*, std::streamsize n ) override { return n; }
+};
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   EmailAddress address1{ "klaus.iglberger@gmx.de" };
+   std::cout << "\n Original email address: " << address1 << "\n\n";
+
+   EmailAddress address2 = address1;
+   std::cout << " Original email after copy construction: " << address1 << "\n"
+             << " New email after copy construction: " << address2 << "\n\n";
+
+   EmailAddress address3 = std::move(address1);
+   std::cout << " Original email after move construction: " << address1 << "\n"
+             << " New email after move construction: " << address3 << "\n\n";
+
+   address2 = std::move(address3);
+   std::cout << " Original email address after move assignment: " << address3 << "\n"
+             << " Resulting email address after move assignment: " << address2 << "\n\n";
+
+   // Printing 1 million email addresses to a null stream
+   {
+      constexpr std::size_t N( 1000000UL );
+
+      std::vector<EmailAddress> cached{};
+      std::vector<RescanningEmailAddress> rescanning{};
+      cached.reserve( N );
+      rescanning.reserve( N );
+
+      for( std::size_t i=0UL; i<N; ++i ) {
+         std::string address{ "klaus.iglberger" + std::to_string( i ) + "@mail.server.co.uk" };
+         rescanning.emplace_back( address );
+         cached.emplace_back( std::move(address) );
+      }
+
+      NullBuffer buffer{};
+      std::ostream null{ &buffer };
+
+      double const t1 = benchmark( [&]{ for( auto const& a : rescanning ) null << a << '\n'; } );
+      double const t2 = benchmark( [&]{ for( auto const& a : cached ) null << a << '\n'; } );
+
+      std::cout << " Printing " << N << " email addresses\n"
+                << "  Rescanning is_valid(): " << t1 << "s\n"
+                << "  Cached validity:       " << t2 << "s\n\n";
+   }
+
+   return EXIT_SUCCESS;
+}
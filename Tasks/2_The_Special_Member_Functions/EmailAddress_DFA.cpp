@@ -0,0 +1,300 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_DFA.cpp
+* \brief C++ Training - Example for a single-pass, table-driven email address validation
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the runtime of the multi-pass 'is_email_address()' function with the
+*       single-pass deterministic finite automaton (DFA) for mostly valid and for mostly invalid
+*       email addresses. Why can the DFA be used during compile time, but the original function
+*       can't?
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+template< typename RandomAccessIt >
+constexpr bool is_valid_email_part( RandomAccessIt first, RandomAccessIt last )
+{
+   auto const isalnum_or_dots_or_underscore =
+      []( char a ){ return isalnum(a) || a == '.' || a == '_'; };
+
+   auto const adjacent_dots =
+      []( char a, char b ){ return a == '.' && b == '.'; };
+
+   return first != last &&
+          std::all_of( first, last, isalnum_or_dots_or_underscore ) &&
+          std::adjacent_find( first, last, adjacent_dots ) == last &&
+          *first != '.' &&
+          *(last-1) != '.';
+}
+
+template< typename RandomAccessIt >
+constexpr bool is_email_address( RandomAccessIt first, RandomAccessIt last )
+{
+   auto const firstAt = std::find( first, last, '@' );
+   auto const firstDotAfterAt = std::find( firstAt, last, '.' );
+
+   return firstAt != last &&
+          firstDotAfterAt != last &&
+          is_valid_email_part( first, firstAt ) &&
+          is_valid_email_part( firstAt+1, firstDotAfterAt ) &&
+          is_valid_email_part( firstDotAfterAt+1, last );
+
+}
+
+
+//---- <EmailAddressDFA.h> ------------------------------------------------------------------------
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton:
+//   Start    : Nothing read yet
+//   Local    : Within the local part, after a word character
+//   LocalDot : Within the local part, directly after a dot
+//   At       : Directly after the '@'
+//   Domain   : Within the domain, i.e. between the '@' and the first dot after it
+//   TldStart : Directly after a dot after the domain
+//   Tld      : After the domain, after a word character (the only accepting state)
+//   Reject   : Invalid address (sink)
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::size_t state_count{ 8UL };
+
+inline constexpr std::array<std::array<State,4>,state_count> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,state_count> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr State next( State state, char c ) noexcept
+{
+   return transitions[std::size_t(state)]
+                     [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+}
+
+struct Result
+{
+   bool valid{ false };
+   std::size_t at{ 0UL };   // Position of the '@'
+   std::size_t dot{ 0UL };  // Position of the first dot after the '@'
+};
+
+// Validates the given address in a single left-to-right pass and records the position of the
+// '@' and of the first dot after the '@' on the way
+constexpr Result validate( std::string_view address ) noexcept
+{
+   Result result{};
+   State state{ State::Start };
+
+   for( std::size_t i=0UL; i<address.size(); ++i )
+   {
+      State const following{ next( state, address[i] ) };
+
+      if( following == State::Reject ) {
+         return result;
+      }
+      if( following == State::At ) {
+         result.at = i;
+      }
+      else if( state == State::Domain && following == State::TldStart ) {
+         result.dot = i;
+      }
+
+      state = following;
+   }
+
+   result.valid = ( state == State::Tld );
+   return result;
+}
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   return validate( address ).valid;
+}
+
+} // namespace dfa
+
+
+static_assert(  dfa::is_email_address( "klaus.iglberger@gmx.de" ) );
+static_assert(  dfa::is_email_address( "k_i@mail.server.co.uk" ) );
+static_assert( !dfa::is_email_address( "" ) );
+static_assert( !dfa::is_email_address( "@gmx.de" ) );
+static_assert( !dfa::is_email_address( "klaus.iglberger@" ) );
+static_assert( !dfa::is_email_address( "klaus.@gmx.de" ) );
+static_assert( !dfa::is_email_address( ".iglberger@gmx.de" ) );
+static_assert( !dfa::is_email_address( "klaus..iglberger@gmx.de" ) );
+static_assert( !dfa::is_email_address( "klaus.iglberger@.de" ) );
+static_assert( !dfa::is_email_address( "klaus.iglberger@gmx." ) );
+static_assert( !dfa::is_email_address( "klaus.iglberger@gmx..de" ) );
+static_assert( !dfa::is_email_address( "klaus.iglberger@@gmx.de" ) );
+static_assert( !dfa::is_email_address( "klaus@iglberger@gmx.de" ) );
+static_assert( dfa::validate( "klaus.iglberger@gmx.de" ).at == 15UL );
+static_assert( dfa::validate( "klaus.iglberger@gmx.de" ).dot == 19UL );
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::is_email_address( address_ ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+// Creates 'n' addresses, of which approximately the given fraction is invalid
+std::vector<std::string> create_corpus( std::size_t n, double invalid_fraction )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk" };
+   static constexpr char const* defects[] =
+      { "..", "@", "-", ".@", " " };
+
+   std::mt19937 rng{ 42U };
+   std::bernoulli_distribution invalid( invalid_fraction );
+
+   std::vector<std::string> corpus( n );
+   for( auto& a : corpus ) {
+      a = std::string{ locals[rng()%5U] } + std::to_string( rng()%10000U );
+      if( invalid( rng ) ) a += defects[rng()%5U];
+      a += '@';
+      a += domains[rng()%3U];
+   }
+   return corpus;
+}
+
+template< typename Validate >
+double benchmark( std::vector<std::string> const& corpus, std::size_t& valid, Validate validate )
+{
+   constexpr std::size_t repetitions{ 5UL };
+
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   valid = 0UL;
+   for( std::size_t r=0UL; r<repetitions; ++r ) {
+      for( auto const& a : corpus ) {
+         valid += validate( a );
+      }
+   }
+   valid /= repetitions;
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 1000000UL );
+
+   for( double const invalid_fraction : { 0.05, 0.95 } )
+   {
+      std::vector<std::string> const corpus{ create_corpus( N, invalid_fraction ) };
+
+      std::size_t valid_multipass{}, valid_dfa{};
+
+      double const multipass = benchmark( corpus, valid_multipass, []( std::string const& a ){
+         return is_email_address( a.begin(), a.end() );
+      } );
+      double const single = benchmark( corpus, valid_dfa, []( std::string const& a ){
+         return dfa::is_email_address( a );
+      } );
+
+      std::cout << "\n " << ( invalid_fraction < 0.5 ? "Valid-heavy" : "Invalid-heavy" )
+                << " corpus (" << N << " addresses)\n"
+                << "  multi-pass is_email_address(): " << multipass << "s (" << valid_multipass
+                << " valid)\n"
+                << "  single-pass DFA:               " << single << "s (" << valid_dfa
+                << " valid)\n";
+
+      // Comparing the verdict for every single address, since equal counts could hide
+      // differences, which cancel each other out
+      auto const mismatch = std::find_if( corpus.begin(), corpus.end(), []( std::string const& a ){
+         return is_email_address( a.begin(), a.end() ) != dfa::is_email_address( a );
+      } );
+      if( mismatch != corpus.end() ) {
+         std::cerr << "  RESULTS DIFFER (first for '" << *mismatch << "')!\n";
+      }
+   }
+
+   EmailAddress const address{ "klaus.iglberger@gmx.de" };
+   std::cout << "\n Email address: " << address << "\n\n";
+
+   return EXIT_SUCCESS;
+}
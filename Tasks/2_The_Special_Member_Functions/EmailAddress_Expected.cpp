@@ -0,0 +1,282 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Expected.cpp
+* \brief C++ Training - Example for the non-throwing creation of email addresses (C++23)
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the runtime of creating email addresses via the throwing constructor and via the
+*       'try_create()' factory function for different ratios of invalid input. At which ratio
+*       does the exception handling start to dominate the runtime?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// The rules of a valid email address, which can be violated
+enum class EmailError : std::uint8_t
+{
+   MissingAt,         // No '@'
+   MissingDot,        // No '.' after the '@'
+   EmptyLocalPart,    // Nothing in front of the '@'
+   EmptyDomain,       // Nothing between the '@' and the first following '.'
+   EmptyTld,          // Nothing after the first '.' after the '@'
+   InvalidCharacter,  // Neither alphanumeric, nor '.' or '_'
+   MultipleAt,        // A second '@'
+   LeadingDot,        // Part starting with a '.'
+   TrailingDot,       // Part ending with a '.'
+   AdjacentDots,      // Two consecutive '.'
+};
+
+constexpr std::string_view to_string( EmailError error )
+{
+   switch( error ) {
+      case EmailError::MissingAt:        return "missing '@'";
+      case EmailError::MissingDot:       return "missing '.' after '@'";
+      case EmailError::EmptyLocalPart:   return "empty local part";
+      case EmailError::EmptyDomain:      return "empty domain";
+      case EmailError::EmptyTld:         return "empty top-level domain";
+      case EmailError::InvalidCharacter: return "invalid character";
+      case EmailError::MultipleAt:       return "multiple '@'";
+      case EmailError::LeadingDot:       return "leading dot";
+      case EmailError::TrailingDot:      return "trailing dot";
+      case EmailError::AdjacentDots:     return "adjacent dots";
+   }
+   return "unknown error";
+}
+
+std::ostream& operator<<( std::ostream& os, EmailError error )
+{
+   return os << to_string( error );
+}
+
+// Checks the rules of 'is_valid_email_part()' one after another and reports the first
+// violated rule
+inline std::expected<void,EmailError>
+   validate_email_part( std::string_view part, EmailError empty )
+{
+   if( part.empty() ) {
+      return std::unexpected( empty );
+   }
+
+   for( char const c : part ) {
+      if( c == '@' ) return std::unexpected( EmailError::MultipleAt );
+      if( !std::isalnum( static_cast<unsigned char>( c ) ) && c != '.' && c != '_' ) {
+         return std::unexpected( EmailError::InvalidCharacter );
+      }
+   }
+
+   if( part.find( ".." ) != std::string_view::npos ) {
+      return std::unexpected( EmailError::AdjacentDots );
+   }
+   if( part.front() == '.' ) {
+      return std::unexpected( EmailError::LeadingDot );
+   }
+   if( part.back() == '.' ) {
+      return std::unexpected( EmailError::TrailingDot );
+   }
+
+   return {};
+}
+
+// Accepts exactly the same addresses as 'is_email_address()', but reports the reason for a
+// rejection
+inline std::expected<void,EmailError> validate_email_address( std::string_view address )
+{
+   std::size_t const at{ address.find( '@' ) };
+   if( at == std::string_view::npos ) {
+      return std::unexpected( EmailError::MissingAt );
+   }
+
+   std::size_t const dot{ address.find( '.', at ) };
+   if( dot == std::string_view::npos ) {
+      return std::unexpected( EmailError::MissingDot );
+   }
+
+   if( auto const local = validate_email_part( address.substr( 0UL, at ),
+                                               EmailError::EmptyLocalPart ); !local ) {
+      return local;
+   }
+   if( auto const domain = validate_email_part( address.substr( at+1UL, dot-at-1UL ),
+                                                EmailError::EmptyDomain ); !domain ) {
+      return domain;
+   }
+   return validate_email_part( address.substr( dot+1UL ), EmailError::EmptyTld );
+}
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( auto const result = validate_email_address( address_ ); !result ) {
+         throw std::invalid_argument( "Invalid email address: " +
+                                      std::string{ to_string( result.error() ) } );
+      }
+   }
+
+   // Creates an email address without throwing on invalid input. The address is constructed
+   // in place within the 'std::expected', i.e. the string is neither copied nor moved again.
+   static std::expected<EmailAddress,EmailError> try_create( std::string address )
+   {
+      if( auto const result = validate_email_address( address ); !result ) {
+         return std::unexpected( result.error() );
+      }
+      return std::expected<EmailAddress,EmailError>{
+         std::in_place, Validated{}, std::move(address) };
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return validate_email_address( address_ ).has_value(); }
+
+ private:
+   // Tag for the creation of an already validated address (not even creatable via '{}')
+   class Validated { friend class EmailAddress; Validated() = default; };
+
+ public:
+   // Only callable by 'try_create()', since the 'Validated' tag is private
+   EmailAddress( Validated, std::string address )
+      : address_{std::move(address)}
+   {}
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+// Creates 'n' addresses, of which approximately the given fraction is invalid
+std::vector<std::string> create_corpus( std::size_t n, double invalid_fraction )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk" };
+   static constexpr char const* defects[] =
+      { "..", "@", "-", ".@", " " };
+
+   std::mt19937 rng{ 42U };
+   std::bernoulli_distribution invalid( invalid_fraction );
+
+   std::vector<std::string> corpus( n );
+   for( auto& a : corpus ) {
+      a = std::string{ locals[rng()%5U] } + std::to_string( rng()%10000U );
+      if( invalid( rng ) ) a += defects[rng()%5U];
+      a += '@';
+      a += domains[rng()%3U];
+   }
+   return corpus;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 1000000UL );
+
+   // Reporting the violated rule for each of the invalid email addresses
+   std::cout << "\n";
+   for( std::string_view const invalid : { "", "@gmx.de", "klaus.iglberger@", "klaus.@gmx.de",
+                                           ".iglberger@gmx.de", "klaus..iglberger@gmx.de",
+                                           "klaus.iglberger@.de", "klaus.iglberger@gmx.",
+                                           "klaus.iglberger@gmx..de", "klaus.iglberger@@gmx.de",
+                                           "klaus@iglberger@gmx.de" } )
+   {
+      auto const address = EmailAddress::try_create( std::string{ invalid } );
+      if( address ) {
+         std::cerr << " INVALID EMAIL '" << invalid << "' ACCEPTED!\n";
+      }
+      else {
+         std::cout << " '" << invalid << "': " << address.error() << "\n";
+      }
+   }
+
+   for( double const invalid_fraction : { 0.0, 0.1, 0.3, 0.6, 0.9 } )
+   {
+      std::vector<std::string> const corpus{ create_corpus( N, invalid_fraction ) };
+
+      std::size_t valid_throwing{ 0UL };
+      std::size_t valid_expected{ 0UL };
+
+      double const throwing = benchmark( [&]{
+         for( auto const& a : corpus ) {
+            try {
+               EmailAddress const address{ a };
+               ++valid_throwing;
+            }
+            catch( std::invalid_argument const& ex ) {}
+         }
+      } );
+
+      double const expected = benchmark( [&]{
+         for( auto const& a : corpus ) {
+            auto const address = EmailAddress::try_create( a );
+            if( address ) ++valid_expected;
+         }
+      } );
+
+      std::cout << "\n " << invalid_fraction*100.0 << "% invalid addresses (" << valid_expected
+                << " of " << N << " valid)\n"
+                << "  Throwing constructor: " << throwing << "s\n"
+                << "  try_create():         " << expected << "s\n";
+
+      if( valid_throwing != valid_expected ) {
+         std::cerr << "  RESULTS DIFFER!\n";
+      }
+   }
+
+   std::cout << "\n";
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,662 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Filter.cpp
+* \brief C++ Training - Example for Bloom and cuckoo filters as membership pre-checks
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the runtime of checking email addresses against a suppression list via a hash
+*       set, via a blocked Bloom filter and via a cuckoo filter, if almost all addresses are not
+*       on the list. How does the false positive rate relate to the size of the filters?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr char to_lower( char c ) noexcept
+{
+   return ( c >= 'A' && c <= 'Z' ) ? static_cast<char>( c - 'A' + 'a' ) : c;
+}
+
+struct Result
+{
+   bool valid{ false };
+   std::uint64_t hash{ 0U };
+};
+
+// Validates the given address and computes its hash in the same pass (see EmailAddress_Hash.cpp)
+constexpr Result validate_and_hash( std::string_view address ) noexcept
+{
+   std::uint64_t hash{ 14695981039346656037ULL };
+   State state{ State::Start };
+   bool domain{ false };
+
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return {};
+
+      hash = ( hash ^ static_cast<unsigned char>( domain ? to_lower( c ) : c ) )
+           * 1099511628211ULL;
+      domain = domain || state == State::At;
+   }
+
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+   hash *= 0xc4ceb9fe1a85ec53ULL;
+   hash ^= hash >> 33;
+
+   return { state == State::Tld, hash };
+}
+
+} // namespace dfa
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      dfa::Result const result{ dfa::validate_and_hash( address_ ) };
+      if( !result.valid ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+      hash_ = result.hash;
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::validate_and_hash( address_ ).valid; }
+   std::uint64_t hash() const noexcept { return hash_; }
+
+   friend bool operator==( EmailAddress const& lhs, EmailAddress const& rhs ) noexcept
+   {
+      return lhs.hash_ == rhs.hash_ && equal( lhs.address_, rhs.address_ );
+   }
+
+ private:
+   static bool equal( std::string_view lhs, std::string_view rhs ) noexcept
+   {
+      if( lhs.size() != rhs.size() ) return false;
+
+      std::size_t const at{ lhs.find( '@' ) };
+      return lhs.substr( 0UL, at+1UL ) == rhs.substr( 0UL, at+1UL ) &&
+             std::equal( lhs.begin()+at+1, lhs.end(), rhs.begin()+at+1,
+                         []( char a, char b ){ return dfa::to_lower( a ) == dfa::to_lower( b ); } );
+   }
+
+   std::string address_;
+   std::uint64_t hash_{};
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+template<>
+struct std::hash<EmailAddress>
+{
+   std::size_t operator()( EmailAddress const& address ) const noexcept
+   {
+      return address.hash();
+   }
+};
+
+
+//---- <BloomFilter.h> ----------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+// Blocked Bloom filter: every address sets one bit in each of the 16 words of a single 64-byte
+// block (i.e. of a single cache line). The block is selected by the upper 32 bits of the hash,
+// the bits within the words by the lower 32 bits multiplied with 16 odd constants.
+class BloomFilter
+{
+ public:
+   explicit BloomFilter( std::size_t expected, std::size_t bits_per_address = 16UL )
+      : blocks_( std::max( expected * bits_per_address / 512UL, 1UL ) )
+   {}
+
+   void insert( std::uint64_t hash ) noexcept
+   {
+      Block& block{ block_of( hash ) };
+      Block const mask{ mask_of( hash ) };
+      for( std::size_t i=0UL; i<words; ++i ) {
+         block.words[i] |= mask.words[i];
+      }
+   }
+
+   // Inserts the given addresses in parallel (fork-join); the words are updated atomically
+   void insert( std::span<EmailAddress const> addresses, std::size_t threads )
+   {
+      std::vector<std::jthread> workers{};
+      for( std::size_t t=0UL; t<threads; ++t ) {
+         workers.emplace_back( [&,t]{
+            std::size_t const begin{ addresses.size() *  t      / threads };
+            std::size_t const end  { addresses.size() * (t+1UL) / threads };
+            for( std::size_t i=begin; i<end; ++i ) {
+               Block& block{ block_of( addresses[i].hash() ) };
+               Block const mask{ mask_of( addresses[i].hash() ) };
+               for( std::size_t w=0UL; w<words; ++w ) {
+                  std::atomic_ref<std::uint32_t>{ block.words[w] }
+                     .fetch_or( mask.words[w], std::memory_order_relaxed );
+               }
+            }
+         } );
+      }
+   }
+
+   // Returns false if the address has definitely not been inserted
+   bool may_contain( std::uint64_t hash ) const noexcept
+   {
+      Block const& block{ block_of( hash ) };
+      Block const mask{ mask_of( hash ) };
+
+#if defined(__SSE2__)
+      __m128i all{ _mm_set1_epi32( -1 ) };
+      for( std::size_t i=0UL; i<words; i+=4UL ) {
+         __m128i const b{ _mm_load_si128( reinterpret_cast<__m128i const*>( block.words+i ) ) };
+         __m128i const m{ _mm_load_si128( reinterpret_cast<__m128i const*>( mask.words+i ) ) };
+         all = _mm_and_si128( all, _mm_cmpeq_epi32( _mm_and_si128( b, m ), m ) );
+      }
+      return _mm_movemask_epi8( all ) == 0xFFFF;
+#else
+      for( std::size_t i=0UL; i<words; ++i ) {
+         if( ( block.words[i] & mask.words[i] ) != mask.words[i] ) return false;
+      }
+      return true;
+#endif
+   }
+
+   std::size_t memory() const noexcept { return blocks_.size() * sizeof(Block); }
+
+   // Binary format: magic, version, number of blocks, blocks (in the byte order of the host)
+   void save( std::string const& path ) const
+   {
+      std::ofstream file{ path, std::ios::binary };
+      std::uint64_t const header[3]{ magic, version, blocks_.size() };
+      file.write( reinterpret_cast<char const*>( header ), sizeof(header) );
+      file.write( reinterpret_cast<char const*>( blocks_.data() ),
+                  static_cast<std::streamsize>( memory() ) );
+      if( !file ) {
+         throw std::runtime_error( "Cannot write Bloom filter to '" + path + "'" );
+      }
+   }
+
+   static BloomFilter load( std::string const& path )
+   {
+      std::ifstream file{ path, std::ios::binary };
+      std::uint64_t header[3]{};
+      file.read( reinterpret_cast<char*>( header ), sizeof(header) );
+      if( !file || header[0] != magic || header[1] != version || header[2] == 0U ) {
+         throw std::runtime_error( "Invalid Bloom filter file '" + path + "'" );
+      }
+
+      // Checking the number of blocks against the file size before allocating any memory
+      std::uintmax_t const size{ std::filesystem::file_size( path ) };
+      if( header[2] > ( size - sizeof(header) ) / sizeof(Block) ) {
+         throw std::runtime_error( "Truncated Bloom filter file '" + path + "'" );
+      }
+
+      BloomFilter filter{ Blocks{ header[2] } };
+      file.read( reinterpret_cast<char*>( filter.blocks_.data() ),
+                 static_cast<std::streamsize>( filter.memory() ) );
+      if( !file ) {
+         throw std::runtime_error( "Truncated Bloom filter file '" + path + "'" );
+      }
+      return filter;
+   }
+
+ private:
+   static constexpr std::size_t words{ 16UL };
+   static constexpr std::uint64_t magic{ 0x4D4F4F4C424C4D45ULL };  // "EMLBLOOM"
+   static constexpr std::uint64_t version{ 1U };
+
+   struct alignas(64) Block
+   {
+      std::uint32_t words[BloomFilter::words]{};
+   };
+
+   struct Blocks { std::size_t count; };
+
+   explicit BloomFilter( Blocks blocks )
+      : blocks_( blocks.count )
+   {}
+
+   Block& block_of( std::uint64_t hash ) noexcept
+   {
+      return blocks_[( ( hash >> 32 ) * blocks_.size() ) >> 32];
+   }
+
+   Block const& block_of( std::uint64_t hash ) const noexcept
+   {
+      return blocks_[( ( hash >> 32 ) * blocks_.size() ) >> 32];
+   }
+
+   static Block mask_of( std::uint64_t hash ) noexcept
+   {
+      static constexpr std::uint32_t salts[words]{
+         0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU,
+         0x9efc4947U, 0x5c6bfb31U, 0x3a8d1e7fU, 0xc1f3b2a5U, 0x6e4d7c19U, 0xd2a9e6f3U,
+         0x1b5f8c2dU, 0xe7c3a4b1U, 0x94d1f06bU, 0x0f2b6d87U };
+
+      auto const key = static_cast<std::uint32_t>( hash );
+      Block mask{};
+      for( std::size_t i=0UL; i<words; ++i ) {
+         mask.words[i] = std::uint32_t{1} << ( ( key * salts[i] ) >> 27 );
+      }
+      return mask;
+   }
+
+   std::vector<Block> blocks_;
+};
+
+
+//---- <CuckooFilter.h> ---------------------------------------------------------------------------
+
+#include <bit>
+
+// Cuckoo filter with buckets of four 16-bit fingerprints. Every fingerprint can reside in two
+// buckets, where the alternative bucket is computed from the bucket and the fingerprint alone.
+// In contrast to a Bloom filter, inserted addresses can be erased again.
+class CuckooFilter
+{
+ public:
+   explicit CuckooFilter( std::size_t expected )
+      : buckets_( std::bit_ceil( std::max( expected * 100UL / 95UL / slots + 1UL, 2UL ) ) )
+   {}
+
+   // Returns false if the address is not inserted, since the filter is full: once a relocation
+   // fails, the last relocated fingerprint is kept aside as victim and all further insertions
+   // are rejected until an address is erased again.
+   bool insert( std::uint64_t hash ) noexcept
+   {
+      if( full_ ) return false;
+      place( index_of( hash ), fingerprint_of( hash ) );
+      return true;
+   }
+
+   bool may_contain( std::uint64_t hash ) const noexcept
+   {
+      std::uint16_t const fingerprint{ fingerprint_of( hash ) };
+      std::size_t const i1{ index_of( hash ) };
+      std::size_t const i2{ alternative( i1, fingerprint ) };
+
+      return contains( buckets_[i1], fingerprint ) || contains( buckets_[i2], fingerprint ) ||
+             is_victim( i1, i2, fingerprint );
+   }
+
+   // Erases an address, which has been inserted before
+   bool erase( std::uint64_t hash ) noexcept
+   {
+      std::uint16_t const fingerprint{ fingerprint_of( hash ) };
+      std::size_t const i1{ index_of( hash ) };
+      std::size_t const i2{ alternative( i1, fingerprint ) };
+
+      if( is_victim( i1, i2, fingerprint ) ) {
+         full_ = false;
+         return true;
+      }
+
+      for( std::size_t i : { i1, i2 } ) {
+         for( auto& slot : buckets_[i] ) {
+            if( slot == fingerprint ) {
+               slot = empty;
+               // Giving the victim another chance, since there is a free slot again
+               if( std::exchange( full_, false ) ) {
+                  place( victim_index_, victim_ );
+               }
+               return true;
+            }
+         }
+      }
+      return false;
+   }
+
+   // Returns true if the filter holds no fingerprint at all
+   bool is_empty() const noexcept
+   {
+      return !full_ && std::all_of( buckets_.begin(), buckets_.end(), []( Bucket const& bucket ){
+         return bucket == Bucket{};
+      } );
+   }
+
+   std::size_t memory() const noexcept { return buckets_.size() * sizeof(Bucket); }
+
+ private:
+   static constexpr std::size_t slots{ 4UL };
+   static constexpr std::size_t max_kicks{ 500UL };
+   static constexpr std::uint16_t empty{ 0U };
+
+   using Bucket = std::array<std::uint16_t,slots>;
+
+   static std::uint16_t fingerprint_of( std::uint64_t hash ) noexcept
+   {
+      auto const fingerprint = static_cast<std::uint16_t>( hash >> 48 );
+      return fingerprint == empty ? std::uint16_t{1} : fingerprint;
+   }
+
+   std::size_t index_of( std::uint64_t hash ) const noexcept
+   {
+      return hash & ( buckets_.size()-1UL );
+   }
+
+   // Involution: alternative( alternative( i, f ), f ) == i
+   std::size_t alternative( std::size_t index, std::uint16_t fingerprint ) const noexcept
+   {
+      return ( index ^ ( fingerprint * 0x5bd1e995UL ) ) & ( buckets_.size()-1UL );
+   }
+
+   static bool contains( Bucket const& bucket, std::uint16_t fingerprint ) noexcept
+   {
+      return bucket[0] == fingerprint || bucket[1] == fingerprint ||
+             bucket[2] == fingerprint || bucket[3] == fingerprint;
+   }
+
+   bool is_victim( std::size_t i1, std::size_t i2, std::uint16_t fingerprint ) const noexcept
+   {
+      return full_ && victim_ == fingerprint && ( victim_index_ == i1 || victim_index_ == i2 );
+   }
+
+   // Places the fingerprint in one of its two buckets, if necessary by relocating other
+   // fingerprints. If the relocation fails, the last relocated fingerprint becomes the victim,
+   // i.e. the given fingerprint is stored in any case.
+   void place( std::size_t index, std::uint16_t fingerprint ) noexcept
+   {
+      for( std::size_t i : { index, alternative( index, fingerprint ) } ) {
+         if( put( i, fingerprint ) ) return;
+      }
+
+      // Evicting the fingerprints of a bucket in round-robin order into their alternative bucket
+      for( std::size_t kick=0UL; kick<max_kicks; ++kick ) {
+         std::swap( fingerprint, buckets_[index][kick % slots] );
+         index = alternative( index, fingerprint );
+         if( put( index, fingerprint ) ) return;
+      }
+
+      victim_ = fingerprint;  // Keeping the last fingerprint, such that nothing is lost
+      victim_index_ = index;
+      full_ = true;
+   }
+
+   bool put( std::size_t index, std::uint16_t fingerprint ) noexcept
+   {
+      for( auto& slot : buckets_[index] ) {
+         if( slot == empty ) {
+            slot = fingerprint;
+            return true;
+         }
+      }
+      return false;
+   }
+
+   std::vector<Bucket> buckets_;
+   std::uint16_t victim_{ empty };
+   std::size_t victim_index_{ 0UL };
+   bool full_{ false };
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <BloomFilter.h>
+//#include <CuckooFilter.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <system_error>
+#include <unordered_set>
+
+#include <unistd.h>
+
+
+std::vector<EmailAddress> create_addresses( std::size_t n, std::string const& prefix )
+{
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk", "web.de", "mail.example.org" };
+
+   std::mt19937 rng{ 42U };
+   std::vector<EmailAddress> addresses{};
+   addresses.reserve( n );
+   for( std::size_t i=0UL; i<n; ++i ) {
+      addresses.emplace_back( prefix + std::to_string( i ) + '@' + domains[rng()%5U] );
+   }
+   return addresses;
+}
+
+// Creates an empty file with a unique name in the temporary directory and returns its path
+std::string create_temporary_file()
+{
+   std::string path{ ( std::filesystem::temp_directory_path() / "suppression_XXXXXX" ).string() };
+   int const fd{ ::mkstemp( path.data() ) };
+   if( fd == -1 ) {
+      throw std::system_error( errno, std::generic_category(), "Cannot create '" + path + "'" );
+   }
+   ::close( fd );
+   return path;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 1000000UL );  // Size of the suppression list
+   constexpr std::size_t Q( 2000000UL );  // Number of queries (1% on the list)
+
+   std::size_t const threads{ std::max( 4U, std::thread::hardware_concurrency() ) };
+
+   std::vector<EmailAddress> const list{ create_addresses( N, "suppressed" ) };
+   std::vector<EmailAddress> const absent{ create_addresses( Q, "customer" ) };
+
+   std::vector<EmailAddress> queries{};
+   queries.reserve( Q );
+   for( std::size_t i=0UL; i<Q; ++i ) {
+      queries.push_back( i%100UL == 0UL ? list[i%N] : absent[i] );
+   }
+
+   std::unordered_set<EmailAddress> const set( list.begin(), list.end() );
+
+   BloomFilter bloom{ N };
+   double const serial = benchmark( [&]{ for( auto const& a : list ) bloom.insert( a.hash() ); } );
+
+   BloomFilter parallel{ N };
+   double const concurrent = benchmark( [&]{ parallel.insert( list, threads ); } );
+
+   CuckooFilter cuckoo{ N };
+   for( auto const& a : list ) {
+      if( !cuckoo.insert( a.hash() ) ) {
+         std::cerr << " Cuckoo filter full!\n";
+         break;
+      }
+   }
+
+   std::cout << "\n Suppression list of " << N << " addresses\n"
+             << "  Bloom filter:  " << bloom.memory() / 1e6 << " MB (built in " << serial
+             << "s, with " << threads << " threads in " << concurrent << "s)\n"
+             << "  Cuckoo filter: " << cuckoo.memory() / 1e6 << " MB\n";
+
+   // False positive rates
+   {
+      std::size_t bloom_fp{ 0UL }, cuckoo_fp{ 0UL };
+      for( auto const& a : absent ) {
+         bloom_fp  += bloom.may_contain( a.hash() );
+         cuckoo_fp += cuckoo.may_contain( a.hash() );
+      }
+      std::cout << "\n False positive rate\n"
+                << "  Bloom filter:  " << 100.0 * bloom_fp  / Q << "%\n"
+                << "  Cuckoo filter: " << 100.0 * cuckoo_fp / Q << "%\n";
+   }
+
+   // Queries per second, including the final lookup in the hash set for every positive answer
+   {
+      std::size_t found1{ 0UL }, found2{ 0UL }, found3{ 0UL };
+
+      double const t1 = benchmark( [&]{
+         for( auto const& q : queries ) found1 += set.contains( q );
+      } );
+      double const t2 = benchmark( [&]{
+         for( auto const& q : queries ) found2 += bloom.may_contain( q.hash() ) && set.contains( q );
+      } );
+      double const t3 = benchmark( [&]{
+         for( auto const& q : queries ) found3 += cuckoo.may_contain( q.hash() ) && set.contains( q );
+      } );
+
+      std::cout << "\n Checking " << Q << " addresses (" << found1 << " suppressed)\n"
+                << "  std::unordered_set:             " << Q / t1 / 1e6 << " M queries/s\n"
+                << "  Bloom filter + hash set:        " << Q / t2 / 1e6 << " M queries/s\n"
+                << "  Cuckoo filter + hash set:       " << Q / t3 / 1e6 << " M queries/s\n";
+
+      if( found1 != found2 || found1 != found3 ) {
+         std::cerr << "  RESULTS DIFFER!\n";
+      }
+   }
+
+   // Serialization and deletion
+   {
+      std::string const path{ create_temporary_file() };
+      parallel.save( path );
+      BloomFilter const loaded{ BloomFilter::load( path ) };
+      std::filesystem::remove( path );
+
+      std::size_t mismatches{ 0UL };
+      for( auto const& q : queries ) {
+         mismatches += ( loaded.may_contain( q.hash() ) != bloom.may_contain( q.hash() ) );
+      }
+
+      std::size_t remaining{ 0UL };
+      for( std::size_t i=0UL; i<N; i+=2UL ) cuckoo.erase( list[i].hash() );
+      for( std::size_t i=1UL; i<N; i+=2UL ) remaining += cuckoo.may_contain( list[i].hash() );
+
+      std::cout << "\n Reloaded Bloom filter: " << mismatches << " mismatches\n"
+                << " Cuckoo filter after erasing every second address: " << remaining
+                << " of " << N/2UL << " remaining addresses found\n";
+   }
+
+   // Inserting and erasing beyond the capacity of the filter: no address may get lost and no
+   // fingerprint may remain after erasing all addresses
+   {
+      constexpr std::size_t capacity( 1000UL );
+      constexpr std::size_t rounds( 100000UL );
+
+      std::mt19937_64 rng{ 42U };
+      CuckooFilter small{ capacity };
+      std::vector<std::uint64_t> members{};
+      std::size_t rejected{ 0UL }, lost{ 0UL };
+
+      for( std::size_t i=0UL; i<rounds; ++i ) {
+         if( members.size() < 4UL*capacity && ( i < 4UL*capacity || rng()%2U == 0U ) ) {
+            std::uint64_t const hash{ rng() };
+            if( small.insert( hash ) ) members.push_back( hash );
+            else ++rejected;
+         }
+         else {
+            std::size_t const victim{ rng() % members.size() };
+            small.erase( members[victim] );
+            members[victim] = members.back();
+            members.pop_back();
+         }
+         if( i%1000UL == 0UL ) {
+            for( std::uint64_t const hash : members ) lost += !small.may_contain( hash );
+         }
+      }
+      for( std::uint64_t const hash : members ) lost += !small.may_contain( hash );
+      for( std::uint64_t const hash : members ) small.erase( hash );
+
+      std::cout << " Cuckoo filter beyond its capacity: " << rejected << " rejected insertions, "
+                << lost << " lost addresses, " << ( small.is_empty() ? "empty" : "NOT EMPTY" )
+                << " after erasing all addresses\n\n";
+      if( lost != 0UL || !small.is_empty() ) {
+         std::cerr << "  RESULTS DIFFER!\n";
+      }
+   }
+
+   return EXIT_SUCCESS;
+}
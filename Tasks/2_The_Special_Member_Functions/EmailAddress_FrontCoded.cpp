@@ -0,0 +1,537 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_FrontCoded.cpp
+* \brief C++ Training - Example for a compact, sorted and immutable store of email addresses
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the memory consumption and the lookup speed of a sorted 'std::vector' of
+*       strings and of the front-coded 'EmailAddressStore' for different block sizes. Why does
+*       sorting by the reversed domain improve the compression?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   State state{ State::Start };
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return false;
+   }
+   return state == State::Tld;
+}
+
+} // namespace dfa
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::is_email_address( address_ ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <EmailAddressStore.h> ----------------------------------------------------------------------
+
+#include <iterator>
+#include <vector>
+
+// Converts between an address and its sort key, which consists of the labels of the domain in
+// reverse order, a separator and the local part (e.g. "klaus@mail.gmx.de" <-> "de.gmx.mail\1klaus",
+// see EmailAddress_RadixSort.cpp). The separator '\1' sorts in front of the '.', which in turn
+// sorts in front of all valid characters of a label. Thus all addresses of a domain precede the
+// addresses of its subdomains, and no address of any other domain (as for instance "web0.de" for
+// "web.de") lies in between.
+class SortKey
+{
+ public:
+   static constexpr char separator{ '\1' };
+
+   static void from_address( std::string_view address, std::string& key )
+   {
+      std::size_t const at{ address.find( '@' ) };
+      key.clear();
+      reverse_labels( address.substr( at+1UL ), key );
+      key += separator;
+      key.append( address.substr( 0UL, at ) );
+   }
+
+   // The smallest possible sort key of all addresses of the given domain, i.e. the sort key for
+   // an empty local part (e.g. "gmx.de" -> "de.gmx\1")
+   static void from_domain( std::string_view domain, std::string& key )
+   {
+      key.clear();
+      reverse_labels( domain, key );
+      key += separator;
+   }
+
+   // Returns true if the key belongs to an address of the given domain or of one of its
+   // subdomains; the domain is given by its sort key (see 'from_domain()')
+   static bool in_domain( std::string_view key, std::string_view domain ) noexcept
+   {
+      std::string_view const labels{ domain.substr( 0UL, domain.size()-1UL ) };
+      return key.starts_with( labels ) && key.size() > labels.size() &&
+             ( key[labels.size()] == separator || key[labels.size()] == '.' );
+   }
+
+   static std::string to_address( std::string_view key )
+   {
+      std::size_t const at{ key.find( separator ) };
+      std::string address{ key.substr( at+1UL ) };
+      address += '@';
+      reverse_labels( key.substr( 0UL, at ), address );
+      return address;
+   }
+
+ private:
+   static void reverse_labels( std::string_view domain, std::string& result )
+   {
+      for( std::size_t end=domain.size(); ; ) {
+         std::size_t const dot{ domain.rfind( '.', end-1UL ) };
+         std::size_t const begin{ dot == std::string_view::npos ? 0UL : dot+1UL };
+         result.append( domain.substr( begin, end-begin ) );
+         if( dot == std::string_view::npos ) break;
+         result += '.';
+         end = dot;
+      }
+   }
+};
+
+
+// Immutable, sorted set of email addresses. The sort keys are front coded in blocks: the first
+// key of a block is stored completely, every following key only stores the length of the
+// prefix it shares with its predecessor and the remaining suffix. A sparse index holds the
+// position of every block, such that a lookup consists of a binary search over the first keys
+// of the blocks and a sequential decoding of a single block.
+class EmailAddressStore
+{
+ public:
+   // Forward iterator over the sort keys, which decodes one key at a time
+   class const_iterator
+   {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type        = std::string_view;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = std::string_view const*;
+      using reference         = std::string_view;
+
+      const_iterator() = default;
+
+      const_iterator( EmailAddressStore const* store, std::size_t index )
+         : store_{ store }
+         , index_{ index }
+      {
+         if( index_ < store_->size_ ) {
+            pos_ = store_->blocks_[index_ / store_->block_size_];
+            decode();
+         }
+      }
+
+      // The sort key of the current address; use 'SortKey::to_address()' to restore the address
+      std::string_view operator*() const noexcept { return key_; }
+
+      const_iterator& operator++()
+      {
+         if( ++index_ < store_->size_ ) {
+            if( index_ % store_->block_size_ == 0UL ) {
+               pos_ = store_->blocks_[index_ / store_->block_size_];
+            }
+            decode();
+         }
+         return *this;
+      }
+
+      const_iterator operator++( int )
+      {
+         const_iterator tmp{ *this };
+         ++(*this);
+         return tmp;
+      }
+
+      friend bool operator==( const_iterator const& lhs, const_iterator const& rhs ) noexcept
+      {
+         return lhs.index_ == rhs.index_;
+      }
+
+    private:
+      void decode()
+      {
+         std::size_t shared{ 0UL };
+         if( index_ % store_->block_size_ != 0UL ) {
+            shared = store_->read_varint( pos_ );
+         }
+         std::size_t const length{ store_->read_varint( pos_ ) };
+
+         key_.resize( shared );
+         key_.append( store_->blob_, pos_, length );
+         pos_ += length;
+      }
+
+      EmailAddressStore const* store_{ nullptr };
+      std::size_t index_{ 0UL };
+      std::size_t pos_{ 0UL };  // Position of the next encoded key within the blob
+      std::string key_{};       // The currently decoded key
+   };
+
+
+   // The block size is clamped to the range from 16 to 64 keys
+   template< typename Range >
+   explicit EmailAddressStore( Range const& addresses, std::size_t block_size = 32UL )
+      : block_size_{ std::clamp( block_size, 16UL, 64UL ) }
+   {
+      std::vector<std::string> keys{};
+      for( EmailAddress const& address : addresses ) {
+         SortKey::from_address( address.value(), keys.emplace_back() );
+      }
+      std::sort( keys.begin(), keys.end() );
+      keys.erase( std::unique( keys.begin(), keys.end() ), keys.end() );
+
+      for( std::size_t i=0UL; i<keys.size(); ++i )
+      {
+         if( i % block_size_ == 0UL ) {
+            blocks_.push_back( blob_.size() );
+            write_varint( keys[i].size() );
+            blob_.append( keys[i] );
+         }
+         else {
+            std::string_view const previous{ keys[i-1UL] };
+            std::size_t const shared( std::mismatch( previous.begin(), previous.end(),
+                                                     keys[i].begin(), keys[i].end() ).first
+                                      - previous.begin() );
+            write_varint( shared );
+            write_varint( keys[i].size() - shared );
+            blob_.append( keys[i], shared );
+         }
+      }
+
+      size_ = keys.size();
+      blob_.shrink_to_fit();
+      blocks_.shrink_to_fit();
+   }
+
+   bool contains( EmailAddress const& address ) const
+   {
+      std::string key{};
+      SortKey::from_address( address.value(), key );
+      const_iterator const pos{ lower_bound_key( key ) };
+      return pos != end() && *pos == key;
+   }
+
+   // Returns an iterator to the first key, which is not less than the key of the given address
+   const_iterator lower_bound( EmailAddress const& address ) const
+   {
+      std::string key{};
+      SortKey::from_address( address.value(), key );
+      return lower_bound_key( key );
+   }
+
+   // Returns an iterator to the first address of the given domain; if there is no such address,
+   // the iterator refers to the first key of a subsequent domain
+   const_iterator lower_bound_domain( std::string_view domain ) const
+   {
+      std::string key{};
+      SortKey::from_domain( domain, key );
+      return lower_bound_key( key );
+   }
+
+   const_iterator begin() const { return const_iterator{ this, 0UL }; }
+   const_iterator end()   const { return const_iterator{ this, size_ }; }
+
+   std::size_t size() const noexcept { return size_; }
+
+   // Number of bytes of the encoded keys and the sparse index
+   std::size_t memory() const noexcept
+   {
+      return blob_.capacity() + blocks_.capacity()*sizeof(std::size_t);
+   }
+
+ private:
+   void write_varint( std::size_t value )
+   {
+      while( value >= 0x80UL ) {
+         blob_ += static_cast<char>( ( value & 0x7FUL ) | 0x80UL );
+         value >>= 7;
+      }
+      blob_ += static_cast<char>( value );
+   }
+
+   std::size_t read_varint( std::size_t& pos ) const noexcept
+   {
+      std::size_t value{ 0UL };
+      for( unsigned shift=0U; ; shift+=7U ) {
+         auto const byte = static_cast<unsigned char>( blob_[pos++] );
+         value |= std::size_t{ byte & 0x7FU } << shift;
+         if( byte < 0x80U ) return value;
+      }
+   }
+
+   std::string_view first_key( std::size_t block ) const noexcept
+   {
+      std::size_t pos{ blocks_[block] };
+      std::size_t const length{ read_varint( pos ) };
+      return std::string_view{ blob_ }.substr( pos, length );
+   }
+
+   const_iterator lower_bound_key( std::string_view key ) const
+   {
+      // The last block, whose first key is not greater than the given key
+      std::size_t low{ 0UL }, high{ blocks_.size() };
+      while( low < high ) {
+         std::size_t const mid{ low + (high-low)/2UL };
+         if( first_key( mid ) <= key ) low = mid+1UL;
+         else high = mid;
+      }
+
+      const_iterator pos{ this, ( low == 0UL ? 0UL : low-1UL ) * block_size_ };
+      while( pos != end() && *pos < key ) ++pos;
+      return pos;
+   }
+
+   std::size_t block_size_;
+   std::size_t size_{ 0UL };
+   std::string blob_{};                 // The front coded keys of all blocks
+   std::vector<std::size_t> blocks_{};  // The position of every block within the blob
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <EmailAddressStore.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+
+// Creates a suppression list of 'n' addresses with common local-part stems and skewed domains
+std::vector<EmailAddress> create_list( std::size_t n, unsigned seed )
+{
+   static constexpr char const* stems[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "newsletter", "support.team" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk", "web.de", "mail.example.org" };
+
+   std::mt19937 rng{ seed };
+   std::vector<EmailAddress> list{};
+   list.reserve( n );
+   for( std::size_t i=0UL; i<n; ++i ) {
+      std::size_t const d{ rng()%1000U };
+      list.emplace_back( std::string{ stems[rng()%6U] } + std::to_string( rng()%100000U ) + '@'
+                         + ( d < 500U ? "" : "host" + std::to_string( d ) + '.' )
+                         + domains[d%5U] );
+   }
+   return list;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 1000000UL );
+   constexpr std::size_t Q( 1000000UL );
+
+   std::vector<EmailAddress> const list{ create_list( N, 42U ) };
+
+   // Half of the queries are contained in the list
+   std::vector<EmailAddress> const queries{ [&]{
+      std::vector<EmailAddress> const others{ create_list( Q, 43U ) };
+      std::mt19937 rng{ 7U };
+      std::vector<EmailAddress> result{};
+      result.reserve( Q );
+      for( std::size_t i=0UL; i<Q; ++i ) {
+         result.push_back( i%2UL == 0UL ? list[rng()%N] : others[i] );
+      }
+      return result;
+   }() };
+
+   // Reference: a sorted vector of the addresses
+   std::vector<std::string> sorted{};
+   sorted.reserve( N );
+   for( auto const& a : list ) {
+      sorted.push_back( a.value() );
+   }
+   std::sort( sorted.begin(), sorted.end() );
+   sorted.erase( std::unique( sorted.begin(), sorted.end() ), sorted.end() );
+
+   std::size_t sorted_bytes{ sorted.capacity() * sizeof(std::string) };
+   for( auto const& s : sorted ) {
+      sorted_bytes += ( s.capacity() > 15UL ? s.capacity()+1UL : 0UL );
+   }
+
+   std::size_t found{ 0UL };
+   double const t = benchmark( [&]{
+      for( auto const& q : queries ) {
+         found += std::binary_search( sorted.begin(), sorted.end(), q.value() );
+      }
+   } );
+
+   std::cout << "\n " << sorted.size() << " distinct addresses, " << Q << " queries ("
+             << found << " contained)\n"
+             << "  sorted std::vector<std::string>: " << sorted_bytes / 1e6 << " MB, "
+             << Q / t / 1e6 << " M lookups/s\n";
+
+   for( std::size_t const block_size : { 16UL, 32UL, 64UL } )
+   {
+      EmailAddressStore const store{ list, block_size };
+
+      std::size_t contained{ 0UL };
+      double const s = benchmark( [&]{
+         for( auto const& q : queries ) {
+            contained += store.contains( q );
+         }
+      } );
+
+      std::cout << "  EmailAddressStore (block size " << block_size << "): "
+                << store.memory() / 1e6 << " MB (ratio "
+                << static_cast<double>( sorted_bytes ) / store.memory() << "), "
+                << Q / s / 1e6 << " M lookups/s\n";
+
+      if( store.size() != sorted.size() || contained != found ) {
+         std::cerr << "  RESULTS DIFFER!\n";
+      }
+   }
+
+   // Addresses of similar domains must not lie between the addresses of a domain and of its
+   // subdomains
+   {
+      std::vector<EmailAddress> const similar{
+         EmailAddress{ "a@web.de" }, EmailAddress{ "b@mail.web.de" }, EmailAddress{ "c@web0.de" },
+         EmailAddress{ "d@web_mail.de" }, EmailAddress{ "e@aweb.de" }, EmailAddress{ "f@web.de" } };
+      EmailAddressStore const store{ similar };
+      std::string domain{};
+      SortKey::from_domain( "web.de", domain );
+
+      std::string locals{};
+      for( auto pos=store.lower_bound_domain( "web.de" ); pos!=store.end(); ++pos ) {
+         if( !SortKey::in_domain( *pos, domain ) ) break;
+         locals += SortKey::to_address( *pos ).front();
+      }
+      if( locals != "afb" ) {
+         std::cerr << "  RESULTS DIFFER!\n";
+      }
+   }
+
+   // Iterating over all addresses of a domain, followed by the addresses of its subdomains
+   {
+      EmailAddressStore const store{ list };
+      std::string domain{};
+      SortKey::from_domain( "web.de", domain );
+
+      std::size_t count{ 0UL }, subdomains{ 0UL };
+      for( auto pos=store.lower_bound_domain( "web.de" ); pos!=store.end(); ++pos ) {
+         if( !SortKey::in_domain( *pos, domain ) ) break;
+         if( !(*pos).starts_with( domain ) ) {
+            ++subdomains;
+         }
+         else if( count++ < 3UL ) {
+            std::cout << "  " << SortKey::to_address( *pos ) << "\n";
+         }
+      }
+      std::cout << "  ... " << count << " addresses in 'web.de' and " << subdomains
+                << " addresses in its subdomains\n\n";
+
+      // All addresses of the domain and of its subdomains must be adjacent
+      std::size_t expected{ 0UL }, expected_subdomains{ 0UL };
+      for( auto const& a : sorted ) {
+         expected            += a.ends_with( "@web.de" );
+         expected_subdomains += a.ends_with( ".web.de" );
+      }
+      if( count != expected || subdomains != expected_subdomains ) {
+         std::cerr << "  RESULTS DIFFER!\n";
+      }
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,505 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_GroupBy.cpp
+* \brief C++ Training - Example for a multi-threaded count of email addresses per domain
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the runtime of counting the email addresses per domain and per top-level domain
+*       via an 'EmailAddress' per line and a 'std::map', and via an aggregator, which validates
+*       the lines and extracts the domains in a single pass and counts into thread-local hash
+*       tables. Why do the thread-local tables not need any synchronization?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+struct Result
+{
+   bool valid{ false };
+   std::size_t at{ 0UL };   // Position of the '@'
+   std::size_t dot{ 0UL };  // Position of the last dot (i.e. the dot in front of the TLD)
+};
+
+// Validates the given address in a single left-to-right pass and records the position of the
+// '@' and of the last dot on the way
+constexpr Result validate( std::string_view address ) noexcept
+{
+   Result result{};
+   State state{ State::Start };
+
+   for( std::size_t i=0UL; i<address.size(); ++i )
+   {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( address[i] )])];
+
+      if( state == State::Reject ) {
+         return result;
+      }
+      if( state == State::At ) {
+         result.at = i;
+      }
+      else if( state == State::TldStart ) {
+         result.dot = i;
+      }
+   }
+
+   result.valid = ( state == State::Tld );
+   return result;
+}
+
+} // namespace dfa
+
+
+static_assert( dfa::validate( "klaus.iglberger@gmx.de" ).at == 15UL );
+static_assert( dfa::validate( "klaus.iglberger@gmx.de" ).dot == 19UL );
+static_assert( dfa::validate( "k_i@mail.server.co.uk" ).dot == 18UL );
+
+
+// Email address, which remembers the position of the '@' and of the dot in front of the
+// top-level domain. Since the positions are found during validation anyway, the local part,
+// the domain and the top-level domain are available in O(1).
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( address_.size() > std::numeric_limits<std::uint16_t>::max() ) {
+         throw std::invalid_argument( "Email address too long" );
+      }
+
+      dfa::Result const result{ dfa::validate( address_ ) };
+      if( !result.valid ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+
+      at_  = static_cast<std::uint16_t>( result.at );
+      dot_ = static_cast<std::uint16_t>( result.dot );
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::validate( address_ ).valid; }
+
+   // "klaus.iglberger" for "klaus.iglberger@mail.server.co.uk"
+   std::string_view local_part() const noexcept
+   {
+      return std::string_view{ address_ }.substr( 0UL, at_ );
+   }
+
+   // "mail.server.co.uk" for "klaus.iglberger@mail.server.co.uk"
+   std::string_view domain() const noexcept
+   {
+      return std::string_view{ address_ }.substr( at_+1UL );
+   }
+
+   // "uk" for "klaus.iglberger@mail.server.co.uk"
+   std::string_view tld() const noexcept
+   {
+      return std::string_view{ address_ }.substr( dot_+1UL );
+   }
+
+ private:
+   std::string address_;
+   std::uint16_t at_{};   // Position of the '@'
+   std::uint16_t dot_{};  // Position of the dot in front of the top-level domain
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <DomainAggregator.h> -----------------------------------------------------------------------
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+constexpr std::uint64_t hash( std::string_view key ) noexcept
+{
+   std::uint64_t h{ 14695981039346656037ULL };
+   for( char const c : key ) {
+      h = ( h ^ static_cast<unsigned char>( c ) ) * 1099511628211ULL;
+   }
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+   return h;
+}
+
+
+// Open addressing hash table with linear probing, which counts the occurrences of keys. The
+// table does not own the keys, i.e. the referenced characters must outlive the table.
+class CountTable
+{
+ public:
+   struct Slot
+   {
+      std::string_view key{};
+      std::uint64_t hash{ 0U };
+      std::size_t count{ 0UL };  // 0 marks an empty slot
+   };
+
+   void add( std::string_view key, std::uint64_t h, std::size_t count = 1UL )
+   {
+      if( 2UL*( size_+1UL ) > slots_.size() ) grow();
+
+      std::size_t const mask{ slots_.size()-1UL };
+      for( std::size_t i=h&mask; ; i=(i+1UL)&mask ) {
+         Slot& slot{ slots_[i] };
+         if( slot.count == 0UL ) {
+            slot = Slot{ key, h, count };
+            ++size_;
+            return;
+         }
+         if( slot.hash == h && slot.key == key ) {
+            slot.count += count;
+            return;
+         }
+      }
+   }
+
+   std::size_t size() const noexcept { return size_; }
+
+   template< typename Callable >
+   void for_each( Callable callable ) const
+   {
+      for( Slot const& slot : slots_ ) {
+         if( slot.count != 0UL ) callable( slot );
+      }
+   }
+
+ private:
+   void grow()
+   {
+      std::vector<Slot> old( 2UL*slots_.size() );
+      std::swap( old, slots_ );
+      size_ = 0UL;
+      for( Slot const& slot : old ) {
+         if( slot.count != 0UL ) add( slot.key, slot.hash, slot.count );
+      }
+   }
+
+   std::vector<Slot> slots_ = std::vector<Slot>( 256UL );
+   std::size_t size_{ 0UL };
+};
+
+
+using DomainCount = std::pair<std::string_view,std::size_t>;
+
+// Counts the valid email addresses per domain and per top-level domain in a text with one
+// address per line. Every thread validates a line-aligned chunk of the text and counts into
+// its own tables. The tables are then merged in parallel: thread 'p' merges the keys of all
+// threads with 'hash % threads == p'. The counted keys refer to the text, i.e. the text must
+// outlive the aggregator.
+class DomainAggregator
+{
+ public:
+   explicit DomainAggregator( std::size_t threads )
+      : threads_{ std::max( threads, 1UL ) }
+   {}
+
+   void run( std::string_view text )
+   {
+      std::vector<CountTable> local_domains( threads_ ), local_tlds( threads_ );
+      std::vector<std::size_t> local_invalid( threads_ );
+
+      // Counting into thread-local tables (fork-join)
+      {
+         std::vector<std::jthread> workers{};
+         for( std::size_t t=0UL; t<threads_; ++t ) {
+            workers.emplace_back( [&,t]{
+               std::size_t invalid{ 0UL };
+               for_each_line( chunk( text, t ), [&]( std::string_view line ) {
+                  dfa::Result const result{ dfa::validate( line ) };
+                  if( !result.valid ) {
+                     ++invalid;
+                     return;
+                  }
+                  std::string_view const domain{ line.substr( result.at+1UL ) };
+                  std::string_view const tld{ line.substr( result.dot+1UL ) };
+                  local_domains[t].add( domain, hash( domain ) );
+                  local_tlds[t].add( tld, hash( tld ) );
+               } );
+               local_invalid[t] = invalid;
+            } );
+         }
+      }
+
+      // Merging the tables by hash partition (fork-join)
+      domains_.assign( threads_, CountTable{} );
+      tlds_.assign( threads_, CountTable{} );
+      {
+         std::vector<std::jthread> workers{};
+         for( std::size_t p=0UL; p<threads_; ++p ) {
+            workers.emplace_back( [&,p]{
+               for( std::size_t t=0UL; t<threads_; ++t ) {
+                  merge( local_domains[t], domains_[p], p );
+                  merge( local_tlds[t], tlds_[p], p );
+               }
+            } );
+         }
+      }
+
+      invalid_ = 0UL;
+      for( std::size_t const n : local_invalid ) invalid_ += n;
+   }
+
+   std::vector<DomainCount> top_domains( std::size_t k ) const { return top( domains_, k ); }
+   std::vector<DomainCount> top_tlds( std::size_t k ) const { return top( tlds_, k ); }
+
+   std::size_t domains() const noexcept
+   {
+      std::size_t n{ 0UL };
+      for( CountTable const& table : domains_ ) n += table.size();
+      return n;
+   }
+
+   std::size_t invalid() const noexcept { return invalid_; }
+
+ private:
+   // Returns the part of the text processed by thread 't'; every chunk starts after a newline
+   std::string_view chunk( std::string_view text, std::size_t t ) const noexcept
+   {
+      auto const align = [&]( std::size_t pos ) {
+         if( pos == 0UL || pos >= text.size() ) return std::min( pos, text.size() );
+         std::size_t const newline{ text.find( '\n', pos-1UL ) };
+         return newline == std::string_view::npos ? text.size() : newline+1UL;
+      };
+      std::size_t const begin{ align( text.size() *  t      / threads_ ) };
+      std::size_t const end  { align( text.size() * (t+1UL) / threads_ ) };
+      return text.substr( begin, end-begin );
+   }
+
+   template< typename Callable >
+   static void for_each_line( std::string_view text, Callable callable )
+   {
+      char const* pos{ text.data() };
+      char const* const end{ text.data() + text.size() };
+      while( pos < end ) {
+         auto const* newline = static_cast<char const*>( std::memchr( pos, '\n', end-pos ) );
+         char const* const stop{ newline ? newline : end };
+         callable( std::string_view( pos, stop-pos ) );
+         pos = stop+1;
+      }
+   }
+
+   void merge( CountTable const& from, CountTable& to, std::size_t partition ) const
+   {
+      from.for_each( [&]( CountTable::Slot const& slot ) {
+         if( slot.hash % threads_ == partition ) to.add( slot.key, slot.hash, slot.count );
+      } );
+   }
+
+   // Orders by descending count, ties by ascending key
+   static bool by_count( DomainCount const& lhs, DomainCount const& rhs ) noexcept
+   {
+      return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+   }
+
+   static std::vector<DomainCount> top( std::vector<CountTable> const& tables, std::size_t k )
+   {
+      std::vector<DomainCount> result{};
+      for( CountTable const& table : tables ) {
+         table.for_each( [&]( CountTable::Slot const& slot ) {
+            result.emplace_back( slot.key, slot.count );
+         } );
+      }
+      k = std::min( k, result.size() );
+      std::partial_sort( result.begin(), result.begin()+k, result.end(), by_count );
+      result.resize( k );
+      return result;
+   }
+
+   std::size_t threads_;
+   std::vector<CountTable> domains_{};
+   std::vector<CountTable> tlds_{};
+   std::size_t invalid_{ 0UL };
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <DomainAggregator.h>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+
+
+// Creates a text with 'n' lines, of which approximately 1% are invalid. The domains follow a
+// Zipf distribution over 'domains' different domains.
+std::string create_text( std::size_t n, std::size_t domains )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* tlds[] =
+      { "com", "de", "org", "net", "co.uk" };
+
+   std::vector<double> weights( domains );
+   for( std::size_t i=0UL; i<domains; ++i ) {
+      weights[i] = 1.0 / double( i+1UL );
+   }
+
+   std::mt19937 rng{ 42U };
+   std::discrete_distribution<std::size_t> zipf( weights.begin(), weights.end() );
+
+   std::string text{};
+   text.reserve( n*28UL );
+   for( std::size_t i=0UL; i<n; ++i ) {
+      std::size_t const d{ zipf( rng ) };
+      text += locals[rng()%5U];
+      text += std::to_string( rng()%1000U );
+      text += ( rng()%100U == 0U ) ? '.' : '@';
+      text += "host";
+      text += std::to_string( d );
+      text += '.';
+      text += tlds[d%5U];
+      text += '\n';
+   }
+   return text;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 10000000UL );
+   constexpr std::size_t K( 5UL );
+
+   std::size_t const threads{ std::max( 4U, std::thread::hardware_concurrency() ) };
+
+   std::string const text{ create_text( N, 20000UL ) };
+
+   // Naive: an 'EmailAddress' per line and 'std::map's with 'std::string' keys
+   std::map<std::string,std::size_t> domains{}, tlds{};
+   std::size_t invalid{ 0UL };
+
+   double const naive = benchmark( [&]{
+      std::istringstream stream{ text };
+      std::string line{};
+      while( std::getline( stream, line ) ) {
+         try {
+            EmailAddress const address{ line };
+            ++domains[std::string{ address.domain() }];
+            ++tlds[std::string{ address.tld() }];
+         }
+         catch( std::invalid_argument const& ) {
+            ++invalid;
+         }
+      }
+   } );
+
+   DomainAggregator aggregator{ threads };
+   double const aggregated = benchmark( [&]{ aggregator.run( text ); } );
+
+   auto const top_of = [&]( std::map<std::string,std::size_t> const& counts ) {
+      std::vector<DomainCount> result( counts.begin(), counts.end() );
+      std::partial_sort( result.begin(), result.begin()+std::min( K, result.size() ), result.end(),
+                         []( DomainCount const& lhs, DomainCount const& rhs ) {
+                            return lhs.second != rhs.second ? lhs.second > rhs.second
+                                                            : lhs.first < rhs.first; } );
+      result.resize( std::min( K, result.size() ) );
+      return result;
+   };
+
+   std::vector<DomainCount> const top{ aggregator.top_domains( K ) };
+
+   std::cout << "\n Counting " << N << " addresses (" << text.size() / 1e6 << " MB) per domain\n"
+             << "  EmailAddress + std::map:            " << naive << "s\n"
+             << "  Aggregator (" << threads << " threads):             " << aggregated << "s\n"
+             << "\n " << aggregator.domains() << " domains, " << aggregator.invalid()
+             << " invalid addresses, top " << K << " domains:\n";
+   for( auto const& [domain, count] : top ) {
+      std::cout << "  " << std::left << std::setw(16) << domain << std::right << count << "\n";
+   }
+   std::cout << "\n Top level domains:\n";
+   for( auto const& [tld, count] : aggregator.top_tlds( K ) ) {
+      std::cout << "  " << std::left << std::setw(16) << tld << std::right << count << "\n";
+   }
+   std::cout << "\n";
+
+   if( top != top_of( domains ) || aggregator.top_tlds( K ) != top_of( tlds ) ||
+       aggregator.domains() != domains.size() || aggregator.invalid() != invalid ) {
+      std::cerr << " RESULTS DIFFER!\n";
+   }
+
+   return EXIT_SUCCESS;
+}
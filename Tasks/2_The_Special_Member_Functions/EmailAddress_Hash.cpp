@@ -0,0 +1,416 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Hash.cpp
+* \brief C++ Training - Example for a cached hash value and a flat hash set of email addresses
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the runtime of deduplicating a mailing list via a 'std::unordered_set' of
+*       strings, via a 'std::unordered_set' of email addresses with a cached hash value, and via
+*       the open-addressing 'EmailAddressSet'. Why do the fingerprints in the control bytes
+*       reduce the number of string comparisons?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr char to_lower( char c ) noexcept
+{
+   return ( c >= 'A' && c <= 'Z' ) ? static_cast<char>( c - 'A' + 'a' ) : c;
+}
+
+struct Result
+{
+   bool valid{ false };
+   std::uint64_t hash{ 0U };
+};
+
+// Validates the given address and computes its hash in the same pass. The domain is hashed
+// case-insensitively, the local part case-sensitively (FNV-1a plus a final mix of the bits).
+constexpr Result validate_and_hash( std::string_view address ) noexcept
+{
+   std::uint64_t hash{ 14695981039346656037ULL };
+   State state{ State::Start };
+   bool domain{ false };
+
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return {};
+
+      hash = ( hash ^ static_cast<unsigned char>( domain ? to_lower( c ) : c ) )
+           * 1099511628211ULL;
+      domain = domain || state == State::At;
+   }
+
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+   hash *= 0xc4ceb9fe1a85ec53ULL;
+   hash ^= hash >> 33;
+
+   return { state == State::Tld, hash };
+}
+
+} // namespace dfa
+
+
+static_assert( dfa::validate_and_hash( "klaus.iglberger@GMX.de" ).hash ==
+               dfa::validate_and_hash( "klaus.iglberger@gmx.DE" ).hash );
+static_assert( dfa::validate_and_hash( "Klaus.Iglberger@gmx.de" ).hash !=
+               dfa::validate_and_hash( "klaus.iglberger@gmx.de" ).hash );
+
+
+// Email address with a hash value, which is computed once during validation. Two addresses are
+// equal if their local parts are equal and their domains are equal except for the case.
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      dfa::Result const result{ dfa::validate_and_hash( address_ ) };
+      if( !result.valid ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+      hash_ = result.hash;
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::validate_and_hash( address_ ).valid; }
+   std::uint64_t hash() const noexcept { return hash_; }
+
+   friend bool operator==( EmailAddress const& lhs, EmailAddress const& rhs ) noexcept
+   {
+      return lhs.hash_ == rhs.hash_ && equal( lhs.address_, rhs.address_ );
+   }
+
+ private:
+   static bool equal( std::string_view lhs, std::string_view rhs ) noexcept
+   {
+      if( lhs.size() != rhs.size() ) return false;
+
+      std::size_t const at{ lhs.find( '@' ) };
+      return lhs.substr( 0UL, at+1UL ) == rhs.substr( 0UL, at+1UL ) &&
+             std::equal( lhs.begin()+at+1, lhs.end(), rhs.begin()+at+1,
+                         []( char a, char b ){ return dfa::to_lower( a ) == dfa::to_lower( b ); } );
+   }
+
+   std::string address_;
+   std::uint64_t hash_{};
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+template<>
+struct std::hash<EmailAddress>
+{
+   std::size_t operator()( EmailAddress const& address ) const noexcept
+   {
+      return address.hash();
+   }
+};
+
+
+//---- <EmailAddressSet.h> ------------------------------------------------------------------------
+
+#include <bit>
+#include <deque>
+#include <vector>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+// Open-addressing hash set of email addresses. The table consists of groups of 16 control
+// bytes, which hold a 7-bit fingerprint of the hash value of the according address (or mark an
+// empty slot). A lookup compares all 16 control bytes of a group at once and only compares the
+// addresses with a matching fingerprint. The addresses themselves are stored in insertion order
+// in a 'std::deque', which keeps every address in place when it grows (in contrast to a
+// 'std::vector', which would copy all addresses); a rehash only redistributes indices.
+class EmailAddressSet
+{
+ public:
+   using const_iterator = std::deque<EmailAddress>::const_iterator;
+
+   EmailAddressSet() = default;
+
+   explicit EmailAddressSet( std::size_t capacity )
+   {
+      reserve( capacity );
+   }
+
+   // Inserts the given address, unless an equal address is already contained
+   bool insert( EmailAddress const& address )
+   {
+      if( ( addresses_.size()+1UL ) * 8UL > control_.size() * 7UL ) {
+         rehash( std::max( 2UL*control_.size(), group_size ) );
+      }
+
+      std::uint64_t const hash{ address.hash() };
+      std::uint8_t const fingerprint{ fingerprint_of( hash ) };
+      std::size_t const groups{ control_.size() / group_size };
+
+      for( std::size_t group=hash%groups, step=1UL; ; group=(group+step)%groups, ++step )
+      {
+         std::uint8_t const* const control{ control_.data() + group*group_size };
+
+         for( std::uint32_t m=match( control, fingerprint ); m != 0U; m &= m-1U ) {
+            std::size_t const slot{ group*group_size + std::countr_zero( m ) };
+            if( addresses_[indices_[slot]] == address ) return false;
+         }
+
+         if( std::uint32_t const m=match( control, empty ); m != 0U ) {
+            std::size_t const slot{ group*group_size + std::countr_zero( m ) };
+            addresses_.push_back( address );
+            control_[slot] = fingerprint;
+            indices_[slot] = static_cast<std::uint32_t>( addresses_.size()-1UL );
+            return true;
+         }
+      }
+   }
+
+   bool contains( EmailAddress const& address ) const
+   {
+      if( addresses_.empty() ) return false;
+
+      std::uint64_t const hash{ address.hash() };
+      std::uint8_t const fingerprint{ fingerprint_of( hash ) };
+      std::size_t const groups{ control_.size() / group_size };
+
+      for( std::size_t group=hash%groups, step=1UL; ; group=(group+step)%groups, ++step )
+      {
+         std::uint8_t const* const control{ control_.data() + group*group_size };
+
+         for( std::uint32_t m=match( control, fingerprint ); m != 0U; m &= m-1U ) {
+            std::size_t const slot{ group*group_size + std::countr_zero( m ) };
+            if( addresses_[indices_[slot]] == address ) return true;
+         }
+
+         if( match( control, empty ) != 0U ) return false;
+      }
+   }
+
+   // Prepares the set for the given number of addresses without rehashing
+   void reserve( std::size_t n )
+   {
+      std::size_t const slots{ std::bit_ceil( std::max( n * 8UL / 7UL + 1UL, group_size ) ) };
+      if( slots > control_.size() ) rehash( slots );
+   }
+
+   std::size_t size() const noexcept { return addresses_.size(); }
+
+   const_iterator begin() const noexcept { return addresses_.begin(); }
+   const_iterator end()   const noexcept { return addresses_.end(); }
+
+ private:
+   static constexpr std::size_t group_size{ 16UL };
+   static constexpr std::uint8_t empty{ 0x80 };
+
+   // The 7 most significant bits of the hash (the group is selected by the lower bits)
+   static std::uint8_t fingerprint_of( std::uint64_t hash ) noexcept
+   {
+      return static_cast<std::uint8_t>( hash >> 57 );
+   }
+
+   // Returns a bit mask of all control bytes of the given group, which equal the given byte
+   static std::uint32_t match( std::uint8_t const* control, std::uint8_t byte ) noexcept
+   {
+#if defined(__SSE2__)
+      __m128i const bytes{ _mm_loadu_si128( reinterpret_cast<__m128i const*>( control ) ) };
+      __m128i const equal{ _mm_cmpeq_epi8( bytes, _mm_set1_epi8( static_cast<char>( byte ) ) ) };
+      return static_cast<std::uint32_t>( _mm_movemask_epi8( equal ) );
+#else
+      std::uint32_t mask{ 0U };
+      for( std::size_t i=0UL; i<group_size; ++i ) {
+         mask |= std::uint32_t{ control[i] == byte } << i;
+      }
+      return mask;
+#endif
+   }
+
+   // Redistributes the indices of all addresses to the given (power of two) number of slots
+   void rehash( std::size_t slots )
+   {
+      std::vector<std::uint8_t> control( slots, empty );
+      std::vector<std::uint32_t> indices( slots );
+      std::size_t const groups{ slots / group_size };
+
+      for( std::size_t i=0UL; i<addresses_.size(); ++i )
+      {
+         std::uint64_t const hash{ addresses_[i].hash() };
+
+         for( std::size_t group=hash%groups, step=1UL; ; group=(group+step)%groups, ++step ) {
+            if( std::uint32_t const m=match( &control[group*group_size], empty ); m != 0U ) {
+               std::size_t const slot{ group*group_size + std::countr_zero( m ) };
+               control[slot] = fingerprint_of( hash );
+               indices[slot] = static_cast<std::uint32_t>( i );
+               break;
+            }
+         }
+      }
+
+      control_.swap( control );
+      indices_.swap( indices );
+   }
+
+   std::vector<std::uint8_t> control_{};   // Fingerprints or 'empty'
+   std::vector<std::uint32_t> indices_{};  // Indices into 'addresses_'
+   std::deque<EmailAddress> addresses_{};  // Stable on growth
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <EmailAddressSet.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+
+
+// Creates a mailing list of 'n' addresses, which are drawn from 'distinct' distinct addresses
+std::vector<EmailAddress> create_mailing_list( std::size_t n, std::size_t distinct )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* tlds[] = { "com", "de", "org", "net", "co.uk" };
+
+   std::mt19937 rng{ 42U };
+   std::vector<EmailAddress> list{};
+   list.reserve( n );
+   for( std::size_t i=0UL; i<n; ++i ) {
+      std::size_t const k{ rng()%distinct };
+      list.emplace_back( std::string{ locals[k%5UL] } + std::to_string( k ) + "@host"
+                         + std::to_string( k%5000UL ) + '.' + tlds[k%5UL] );
+   }
+   return list;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 5000000UL );
+   constexpr std::size_t distinct( 2500000UL );
+
+   EmailAddress const address1{ "klaus.iglberger@GMX.de" };
+   EmailAddress const address2{ "klaus.iglberger@gmx.DE" };
+   std::cout << "\n " << address1 << ( address1 == address2 ? " == " : " != " ) << address2
+             << "\n";
+
+   std::vector<EmailAddress> const list{ create_mailing_list( N, distinct ) };
+
+   std::size_t size1{}, size2{}, size3{};
+
+   double const strings = benchmark( [&]{
+      std::unordered_set<std::string> set{};
+      for( auto const& a : list ) {
+         set.insert( a.value() );
+      }
+      size1 = set.size();
+   } );
+
+   double const cached = benchmark( [&]{
+      std::unordered_set<EmailAddress> set{};
+      for( auto const& a : list ) {
+         set.insert( a );
+      }
+      size2 = set.size();
+   } );
+
+   double const flat = benchmark( [&]{
+      EmailAddressSet set{};
+      for( auto const& a : list ) {
+         set.insert( a );
+      }
+      size3 = set.size();
+   } );
+
+   std::cout << "\n Deduplicating " << N << " email addresses (" << size3 << " distinct)\n"
+             << "  std::unordered_set<std::string>:  " << strings << "s\n"
+             << "  std::unordered_set<EmailAddress>: " << cached << "s\n"
+             << "  EmailAddressSet:                  " << flat << "s\n\n";
+
+   if( size1 != size3 || size2 != size3 ) {
+      std::cerr << " RESULTS DIFFER!\n";
+   }
+
+   return EXIT_SUCCESS;
+}
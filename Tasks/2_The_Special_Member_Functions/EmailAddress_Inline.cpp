@@ -0,0 +1,336 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Inline.cpp
+* \brief C++ Training - Example for storage policies of an email address without heap allocation
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the size, the copy throughput and the scan speed of email addresses based on a
+*       'std::string', on a fixed-capacity inline buffer and on a compact 64-byte buffer, which
+*       spills long addresses to the heap. Which storage is the fastest to copy, which is the
+*       fastest to scan, and why?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   State state{ State::Start };
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return false;
+   }
+   return state == State::Tld;
+}
+
+} // namespace dfa
+
+
+// Maximum length of an email address according to RFC 5321
+inline constexpr std::size_t max_email_length{ 254UL };
+
+
+// Storage policy based on 'std::string' (i.e. heap allocation for more than 15 characters)
+class StringStorage
+{
+ public:
+   explicit StringStorage( std::string_view address )
+      : address_{ address }
+   {}
+
+   std::string_view view() const noexcept { return address_; }
+
+ private:
+   std::string address_;
+};
+
+
+// Storage policy, which keeps all characters inline. The storage is trivially copyable, i.e.
+// a copy is a single 'memcpy()' and a 'std::vector' can relocate its elements via 'memmove()'.
+class InlineStorage
+{
+ public:
+   explicit InlineStorage( std::string_view address ) noexcept
+      : size_{ static_cast<std::uint8_t>( address.size() ) }
+   {
+      std::memcpy( data_, address.data(), address.size() );
+   }
+
+   std::string_view view() const noexcept { return { data_, size_ }; }
+
+ private:
+   std::uint8_t size_;
+   char data_[max_email_length];
+};
+
+static_assert( sizeof(InlineStorage) == max_email_length+1UL );
+static_assert( std::is_trivially_copyable_v<InlineStorage> );
+
+
+// Storage policy with 64 bytes, which keeps addresses of up to 63 characters inline and
+// spills longer addresses to the heap. In the latter case the buffer holds the heap pointer.
+class CompactStorage
+{
+ public:
+   explicit CompactStorage( std::string_view address )
+      : size_{ static_cast<std::uint8_t>( address.size() ) }
+   {
+      init( address.data() );
+   }
+
+   ~CompactStorage()
+   {
+      if( !is_inline() ) delete[] heap();
+   }
+
+   CompactStorage( CompactStorage const& other )
+      : size_{ other.size_ }
+   {
+      init( other.view().data() );
+   }
+
+   CompactStorage& operator=( CompactStorage const& other )
+   {
+      CompactStorage copy{ other };  // Copy-and-swap for the strong exception guarantee
+      std::swap( size_, copy.size_ );
+      std::swap( buffer_, copy.buffer_ );
+      return *this;
+   }
+
+   std::string_view view() const noexcept
+   {
+      return { is_inline() ? buffer_ : heap(), size_ };
+   }
+
+ private:
+   static constexpr std::size_t capacity{ 63UL };
+
+   bool is_inline() const noexcept { return size_ <= capacity; }
+
+   char* heap() const noexcept
+   {
+      char* ptr;
+      std::memcpy( &ptr, buffer_, sizeof(ptr) );
+      return ptr;
+   }
+
+   void init( char const* data )
+   {
+      if( is_inline() ) {
+         std::memcpy( buffer_, data, size_ );
+      }
+      else {
+         char* const ptr = new char[size_];
+         std::memcpy( ptr, data, size_ );
+         std::memcpy( buffer_, &ptr, sizeof(ptr) );
+      }
+   }
+
+   std::uint8_t size_;
+   char buffer_[capacity];
+};
+
+static_assert( sizeof(CompactStorage) == 64UL );
+
+
+template< typename Storage >
+class BasicEmailAddress
+{
+ public:
+   explicit BasicEmailAddress( std::string_view address )
+      : storage_{ checked( address ) }
+   {}
+
+   ~BasicEmailAddress() = default;
+   BasicEmailAddress( BasicEmailAddress const& ) = default;
+   BasicEmailAddress& operator=( BasicEmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string_view value() const noexcept { return storage_.view(); }
+   bool is_valid() const { return dfa::is_email_address( value() ); }
+
+ private:
+   // Validates the address before any storage is initialized
+   static std::string_view checked( std::string_view address )
+   {
+      if( address.size() > max_email_length ) {
+         throw std::invalid_argument( "Email address too long" );
+      }
+      if( !dfa::is_email_address( address ) ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+      return address;
+   }
+
+   Storage storage_;
+};
+
+template< typename Storage >
+std::ostream& operator<<( std::ostream& os, BasicEmailAddress<Storage> const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+using EmailAddress        = BasicEmailAddress<StringStorage>;
+using InlineEmailAddress  = BasicEmailAddress<InlineStorage>;
+using CompactEmailAddress = BasicEmailAddress<CompactStorage>;
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+// Creates 'n' addresses, of which approximately 5% are longer than 63 characters
+std::vector<std::string> create_corpus( std::size_t n )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk" };
+
+   std::mt19937 rng{ 42U };
+   std::vector<std::string> corpus( n );
+   for( auto& a : corpus ) {
+      a = std::string{ locals[rng()%5U] } + std::to_string( rng()%10000U );
+      if( rng()%20U == 0U ) a += ".with.a.very.long.local.part.for.the.heap.spill";
+      a += '@';
+      a += domains[rng()%3U];
+   }
+   return corpus;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+template< typename Address >
+void run( char const* name, std::vector<std::string> const& corpus )
+{
+   constexpr std::size_t repetitions{ 10UL };
+
+   std::vector<Address> addresses{};
+   addresses.reserve( corpus.size() );
+   for( auto const& a : corpus ) {
+      addresses.emplace_back( a );
+   }
+
+   std::size_t checksum{ 0UL };
+
+   // Copying all addresses into an already touched buffer, i.e. without page faults
+   std::vector<Address> copies{ addresses };
+   double const copy = benchmark( [&]{
+      for( std::size_t r=0UL; r<repetitions; ++r ) {
+         copies.clear();
+         for( auto const& a : addresses ) {
+            copies.push_back( a );
+         }
+         checksum += copies.back().value().size();
+      }
+   } );
+
+   // Counting the German addresses
+   double const scan = benchmark( [&]{
+      for( std::size_t r=0UL; r<repetitions; ++r ) {
+         for( auto const& a : addresses ) {
+            checksum += a.value().ends_with( ".de" );
+         }
+      }
+   } );
+
+   std::cout << "  " << std::left << std::setw(20) << name << std::right
+             << " sizeof = " << std::setw(3) << sizeof(Address)
+             << ", copy = " << std::setw(9) << copy
+             << "s, scan = " << std::setw(9) << scan << "s (" << checksum << ")\n";
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 1000000UL );
+
+   CompactEmailAddress const address{ "klaus.iglberger@gmx.de" };
+   std::cout << "\n Email address: " << address << "\n";
+
+   std::vector<std::string> const corpus{ create_corpus( N ) };
+
+   std::cout << "\n Copying and scanning " << N << " email addresses\n";
+   run<EmailAddress>       ( "std::string",  corpus );
+   run<InlineEmailAddress> ( "Inline (254)", corpus );
+   run<CompactEmailAddress>( "Compact (64)", corpus );
+   std::cout << "\n";
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,517 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Interned.cpp
+* \brief C++ Training - Example for email addresses with interned domains
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the memory consumption and the speed of domain and address comparisons of
+*       email addresses based on a 'std::string' and of email addresses, which store the local
+*       part and a 32-bit handle into a concurrent table of interned domains. The domains of the
+*       synthetic address book follow a Zipf distribution.
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   State state{ State::Start };
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return false;
+   }
+   return state == State::Tld;
+}
+
+} // namespace dfa
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::is_email_address( address_ ); }
+
+   friend bool operator==( EmailAddress const&, EmailAddress const& ) = default;
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <DomainTable.h> ----------------------------------------------------------------------------
+
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+// Concurrent, append-only table of interned domains. Every domain is stored exactly once and is
+// identified by a 32-bit handle. Insertions are serialized per shard; the lookup of a domain by
+// its handle is lock-free, since interned domains never move and are never removed.
+class DomainTable
+{
+ public:
+   using Handle = std::uint32_t;
+
+   DomainTable() = default;
+
+   ~DomainTable()
+   {
+      for( auto& segment : segments_ ) {
+         delete[] segment.load( std::memory_order_relaxed );
+      }
+   }
+
+   DomainTable( DomainTable const& ) = delete;
+   DomainTable& operator=( DomainTable const& ) = delete;
+
+   // Returns the handle of the given domain, which is inserted on first use
+   Handle intern( std::string_view domain )
+   {
+      Shard& shard{ shard_of( domain ) };
+      std::lock_guard const lock{ shard.mutex };
+
+      if( auto const pos = shard.handles.find( domain ); pos != shard.handles.end() ) {
+         return pos->second;
+      }
+
+      std::size_t const index{ size_.fetch_add( 1UL, std::memory_order_relaxed ) };
+      if( index > std::numeric_limits<Handle>::max() ) {
+         throw std::length_error( "Too many domains" );
+      }
+
+      std::string& entry{ slot( index ) };
+      entry = domain;
+      shard.handles.emplace( entry, static_cast<Handle>( index ) );
+      return static_cast<Handle>( index );
+   }
+
+   // Returns the handle of the given domain, if it has been interned before
+   std::optional<Handle> find( std::string_view domain ) const
+   {
+      Shard const& shard{ shard_of( domain ) };
+      std::lock_guard const lock{ shard.mutex };
+
+      auto const pos = shard.handles.find( domain );
+      return pos != shard.handles.end() ? std::optional<Handle>{ pos->second } : std::nullopt;
+   }
+
+   std::string_view operator[]( Handle handle ) const noexcept
+   {
+      auto const [k,offset] = locate( handle );
+      return segments_[k].load( std::memory_order_acquire )[offset];
+   }
+
+   std::size_t size() const noexcept { return size_.load( std::memory_order_relaxed ); }
+
+   // Estimated number of bytes of the domains, the segments and the hash maps
+   std::size_t memory() const
+   {
+      std::size_t bytes{ 0UL };
+      for( std::size_t k=0UL; k<max_segments; ++k ) {
+         std::string const* const segment = segments_[k].load( std::memory_order_acquire );
+         if( segment == nullptr ) continue;
+         bytes += segment_size( k ) * sizeof(std::string);
+         for( std::size_t i=0UL; i<segment_size( k ); ++i ) {
+            if( segment[i].capacity() > 15UL ) bytes += segment[i].capacity() + 1UL;
+         }
+      }
+      for( auto const& shard : shards_ ) {
+         std::lock_guard const lock{ shard.mutex };
+         bytes += shard.handles.bucket_count() * sizeof(void*)
+                + shard.handles.size() * ( sizeof(void*) + sizeof(std::size_t) +
+                                           sizeof(std::pair<std::string_view const,Handle>) );
+      }
+      return bytes;
+   }
+
+ private:
+   static constexpr std::size_t shard_count{ 64UL };
+   static constexpr std::size_t first_segment_size{ 1024UL };
+   static constexpr std::size_t max_segments{ 23UL };  // Enough for 2^32 domains
+
+   struct Shard
+   {
+      mutable std::mutex mutex{};
+      std::unordered_map<std::string_view,Handle> handles{};  // Views into the segments
+   };
+
+   Shard& shard_of( std::string_view domain ) noexcept
+   {
+      return shards_[std::hash<std::string_view>{}( domain ) % shard_count];
+   }
+
+   Shard const& shard_of( std::string_view domain ) const noexcept
+   {
+      return shards_[std::hash<std::string_view>{}( domain ) % shard_count];
+   }
+
+   static constexpr std::size_t segment_size( std::size_t k ) noexcept
+   {
+      return first_segment_size << k;
+   }
+
+   // Segment k holds the domains [first_segment_size*(2^k-1), first_segment_size*(2^(k+1)-1))
+   static constexpr std::pair<std::size_t,std::size_t> locate( std::size_t index ) noexcept
+   {
+      std::size_t const k( std::bit_width( index/first_segment_size + 1UL ) - 1UL );
+      return { k, index - first_segment_size*( ( std::size_t{1} << k ) - 1UL ) };
+   }
+
+   // Returns the slot of the given index; a missing segment is installed via compare-and-swap,
+   // since insertions into different shards may race for the same segment
+   std::string& slot( std::size_t index )
+   {
+      auto const [k,offset] = locate( index );
+      std::string* segment = segments_[k].load( std::memory_order_acquire );
+
+      if( segment == nullptr ) {
+         std::string* const fresh = new std::string[segment_size( k )];
+         if( segments_[k].compare_exchange_strong( segment, fresh, std::memory_order_acq_rel ) ) {
+            segment = fresh;
+         }
+         else {
+            delete[] fresh;  // Another thread was faster; 'segment' holds its segment
+         }
+      }
+
+      return segment[offset];
+   }
+
+   std::array<Shard,shard_count> shards_{};
+   std::array<std::atomic<std::string*>,max_segments> segments_{};
+   std::atomic<std::size_t> size_{ 0UL };
+};
+
+// The table of all domains of all interned email addresses
+inline DomainTable domains{};
+
+
+// Email address, which stores the local part and a handle to the interned domain. Two domains
+// are equal if and only if their handles are equal.
+class InternedEmailAddress
+{
+ public:
+   explicit InternedEmailAddress( std::string_view address )
+   {
+      if( !dfa::is_email_address( address ) ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+
+      std::size_t const at{ address.find( '@' ) };
+      local_  = address.substr( 0UL, at );
+      domain_ = domains.intern( address.substr( at+1UL ) );
+   }
+
+   ~InternedEmailAddress() = default;
+   InternedEmailAddress( InternedEmailAddress const& ) = default;
+   InternedEmailAddress& operator=( InternedEmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string_view local_part() const noexcept { return local_; }
+   std::string_view domain() const noexcept { return domains[domain_]; }
+   DomainTable::Handle domain_handle() const noexcept { return domain_; }
+
+   // Rebuilds the complete address
+   std::string value() const
+   {
+      std::string_view const domain{ this->domain() };
+      std::string address{};
+      address.reserve( local_.size() + 1UL + domain.size() );
+      address.append( local_ ).append( 1UL, '@' ).append( domain );
+      return address;
+   }
+
+   bool is_valid() const { return dfa::is_email_address( value() ); }
+
+   friend bool operator==( InternedEmailAddress const& lhs, InternedEmailAddress const& rhs )
+   {
+      return lhs.domain_ == rhs.domain_ && lhs.local_ == rhs.local_;
+   }
+
+ private:
+   std::string local_{};
+   DomainTable::Handle domain_{};
+};
+
+std::ostream& operator<<( std::ostream& os, InternedEmailAddress const& address )
+{
+   return os << address.local_part() << '@' << address.domain()
+             << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <DomainTable.h>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+// Creates 'n' addresses, whose domains are drawn from 'domain_count' domains with a Zipf
+// distribution (i.e. the k-th most frequent domain has a probability proportional to 1/k)
+std::vector<std::string> create_corpus( std::size_t n, std::size_t domain_count )
+{
+   static constexpr char const* tlds[] = { "com", "de", "org", "net", "co.uk" };
+
+   std::vector<double> cdf( domain_count );
+   double sum{ 0.0 };
+   for( std::size_t k=0UL; k<domain_count; ++k ) {
+      sum += 1.0 / static_cast<double>( k+1UL );
+      cdf[k] = sum;
+   }
+
+   std::mt19937 rng{ 42U };
+   std::uniform_real_distribution<double> uniform( 0.0, sum );
+
+   std::vector<std::string> corpus( n );
+   for( auto& a : corpus ) {
+      std::size_t const rank( std::lower_bound( cdf.begin(), cdf.end(), uniform( rng ) )
+                              - cdf.begin() );
+      a = "user" + std::to_string( rng()%1000000U ) + "@mailhost" + std::to_string( rank )
+        + '.' + tlds[rank%5U];
+   }
+   return corpus;
+}
+
+// Interns all addresses of the corpus in parallel (fork-join)
+std::vector<InternedEmailAddress> intern_corpus( std::vector<std::string> const& corpus,
+                                                 std::size_t threads )
+{
+   std::vector<std::vector<InternedEmailAddress>> parts( threads );
+   {
+      std::vector<std::jthread> workers{};
+      for( std::size_t t=0UL; t<threads; ++t ) {
+         workers.emplace_back( [&,t]{
+            std::size_t const begin{ corpus.size() *  t      / threads };
+            std::size_t const end  { corpus.size() * (t+1UL) / threads };
+            parts[t].reserve( end-begin );
+            for( std::size_t i=begin; i<end; ++i ) {
+               parts[t].emplace_back( corpus[i] );
+            }
+         } );
+      }
+   }
+
+   std::vector<InternedEmailAddress> addresses{};
+   addresses.reserve( corpus.size() );
+   for( auto const& part : parts ) {
+      addresses.insert( addresses.end(), part.begin(), part.end() );
+   }
+   return addresses;
+}
+
+// Estimated number of heap bytes of a string (none in case of the small string optimization)
+std::size_t heap_bytes( std::string const& s )
+{
+   return s.capacity() > 15UL ? s.capacity() + 1UL : 0UL;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 2000000UL );
+   constexpr std::size_t D( 20000UL );
+   constexpr std::size_t repetitions( 10UL );
+
+   std::size_t const threads{ std::max( 4U, std::thread::hardware_concurrency() ) };
+
+   std::vector<std::string> const corpus{ create_corpus( N, D ) };
+
+   std::vector<EmailAddress> plain{};
+   plain.reserve( N );
+   for( auto const& a : corpus ) {
+      plain.emplace_back( a );
+   }
+
+   std::vector<InternedEmailAddress> interned{};
+   double const interning = benchmark( [&]{ interned = intern_corpus( corpus, threads ); } );
+
+   std::cout << "\n Email address: " << interned.front() << "\n"
+             << "\n " << N << " addresses with " << domains.size() << " distinct domains "
+             << "(interned by " << threads << " threads in " << interning << "s)\n";
+
+   // Memory consumption
+   {
+      std::size_t plain_bytes{ N * sizeof(EmailAddress) };
+      for( auto const& a : plain ) {
+         plain_bytes += heap_bytes( a.value() );
+      }
+
+      std::size_t interned_bytes{ N * sizeof(InternedEmailAddress) + domains.memory() };
+      for( auto const& a : interned ) {
+         interned_bytes += heap_bytes( std::string{ a.local_part() } );
+      }
+
+      std::cout << "\n Estimated memory consumption\n"
+                << "  std::string:     " << plain_bytes    / 1e6 << " MB\n"
+                << "  Interned domain: " << interned_bytes / 1e6 << " MB\n";
+   }
+
+   // Counting the addresses of the most frequent domain
+   {
+      std::string_view const domain{ "mailhost0.com" };
+      DomainTable::Handle const handle{ *domains.find( domain ) };
+      std::size_t count1{ 0UL }, count2{ 0UL };
+
+      double const t1 = benchmark( [&]{
+         for( std::size_t r=0UL; r<repetitions; ++r ) {
+            for( auto const& a : plain ) {
+               std::string_view const value{ a.value() };
+               count1 += ( value.substr( value.find( '@' )+1UL ) == domain );
+            }
+         }
+      } );
+
+      double const t2 = benchmark( [&]{
+         for( std::size_t r=0UL; r<repetitions; ++r ) {
+            for( auto const& a : interned ) {
+               count2 += ( a.domain_handle() == handle );
+            }
+         }
+      } );
+
+      std::cout << "\n Domain comparison (" << count1/repetitions << " addresses in '"
+                << domain << "')\n"
+                << "  std::string:     " << t1 << "s\n"
+                << "  Interned domain: " << t2 << "s\n";
+
+      if( count1 != count2 ) {
+         std::cerr << "  RESULTS DIFFER!\n";
+      }
+   }
+
+   // Comparing each address with a random address (every second one with itself)
+   {
+      std::mt19937 rng{ 7U };
+      std::vector<std::size_t> partners( N );
+      for( std::size_t i=0UL; i<N; ++i ) {
+         partners[i] = ( i%2UL == 0UL ) ? i : rng()%N;
+      }
+
+      std::size_t count1{ 0UL }, count2{ 0UL };
+
+      double const t1 = benchmark( [&]{
+         for( std::size_t r=0UL; r<repetitions; ++r ) {
+            for( std::size_t i=0UL; i<N; ++i ) {
+               count1 += ( plain[i] == plain[partners[i]] );
+            }
+         }
+      } );
+
+      double const t2 = benchmark( [&]{
+         for( std::size_t r=0UL; r<repetitions; ++r ) {
+            for( std::size_t i=0UL; i<N; ++i ) {
+               count2 += ( interned[i] == interned[partners[i]] );
+            }
+         }
+      } );
+
+      std::cout << "\n Address comparison (" << count1/repetitions << " equal pairs)\n"
+                << "  std::string:     " << t1 << "s\n"
+                << "  Interned domain: " << t2 << "s\n\n";
+
+      if( count1 != count2 ) {
+         std::cerr << "  RESULTS DIFFER!\n";
+      }
+   }
+
+   return EXIT_SUCCESS;
+}
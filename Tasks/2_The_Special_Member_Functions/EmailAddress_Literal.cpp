@@ -0,0 +1,261 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Literal.cpp
+* \brief C++ Training - Example for compile time validated email address literals
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the runtime of creating a table of 10000 constant email addresses via the
+*       validating 'EmailAddress' constructor and via the compile time validated '_email'
+*       literals. What happens if you uncomment the invalid literal in 'main()'?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   State state{ State::Start };
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return false;
+   }
+   return state == State::Tld;
+}
+
+} // namespace dfa
+
+
+// Email address, which has been validated during compilation. The characters are not copied,
+// but must live in static storage (e.g. a string literal or a 'constexpr' variable).
+class EmailLiteral
+{
+ public:
+   // Fails compilation for an invalid address ('throw' is not allowed in a constant expression)
+   consteval explicit EmailLiteral( std::string_view address )
+      : address_{ address }
+   {
+      if( !dfa::is_email_address( address ) ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   constexpr std::string_view view() const noexcept { return address_; }
+
+ private:
+   std::string_view address_;
+};
+
+// Structural string type, which allows to pass string literals as template arguments
+template< std::size_t N >
+struct FixedString
+{
+   consteval FixedString( char const (&str)[N] )
+   {
+      std::copy_n( str, N, data );
+   }
+
+   constexpr std::string_view view() const noexcept { return { data, N-1UL }; }
+
+   char data[N]{};
+};
+
+// The characters of the literal live in the template parameter object 'S', which has static
+// storage duration
+template< FixedString S >
+consteval EmailLiteral operator""_email()
+{
+   static_assert( dfa::is_email_address( S.view() ), "Invalid email address literal" );
+   return EmailLiteral{ S.view() };
+}
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   // No runtime validation required, since the literal has been validated during compilation
+   EmailAddress( EmailLiteral literal )
+      : address_{ literal.view() }
+   {}
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::is_email_address( address_ ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+
+constexpr std::size_t table_size{ 10000UL };
+constexpr std::size_t max_length{ 40UL };
+
+// Table of constant addresses (e.g. of a configuration), which is generated during compilation
+constexpr auto address_table = []{
+   auto const append_number = []( char*& pos, std::size_t number ) {
+      char digits[20]{};
+      std::size_t count{ 0UL };
+      do { digits[count++] = char( '0' + number%10UL ); number /= 10UL; } while( number > 0UL );
+      while( count > 0UL ) *pos++ = digits[--count];
+   };
+   auto const append = []( char*& pos, std::string_view str ) {
+      pos = std::copy( str.begin(), str.end(), pos );
+   };
+
+   std::array<std::array<char,max_length>,table_size> table{};
+   for( std::size_t i=0UL; i<table_size; ++i ) {
+      char* pos{ table[i].data() };
+      append( pos, i%3UL == 0UL ? "klaus.iglberger" : "user_" );
+      append_number( pos, i );
+      append( pos, "@host" );
+      append_number( pos, i%97UL );
+      append( pos, i%2UL == 0UL ? ".example.com" : ".gmx.de" );
+   }
+   return table;
+}();
+
+// All entries of the table as compile time validated literals; a single invalid entry would
+// fail compilation
+constexpr auto address_literals = []<std::size_t... Is>( std::index_sequence<Is...> ){
+   return std::array<EmailLiteral,table_size>{
+      EmailLiteral{ std::string_view{ address_table[Is].data() } }... };
+}( std::make_index_sequence<table_size>{} );
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t repetitions{ 1000UL };
+
+   EmailAddress const address = "klaus.iglberger@gmx.de"_email;
+   std::cout << "\n Email address: " << address << "\n";
+
+   // EmailAddress const invalid = "klaus..iglberger@gmx.de"_email;  // Compilation error
+
+   std::size_t checksum1{ 0UL }, checksum2{ 0UL };
+
+   double const validating = benchmark( [&]{
+      for( std::size_t r=0UL; r<repetitions; ++r ) {
+         std::vector<EmailAddress> addresses{};
+         addresses.reserve( table_size );
+         for( auto const& entry : address_table ) {
+            addresses.emplace_back( std::string{ entry.data() } );
+         }
+         checksum1 += addresses.back().value().size();
+      }
+   } );
+
+   double const literals = benchmark( [&]{
+      for( std::size_t r=0UL; r<repetitions; ++r ) {
+         std::vector<EmailAddress> addresses{};
+         addresses.reserve( table_size );
+         for( auto const& literal : address_literals ) {
+            addresses.emplace_back( literal );
+         }
+         checksum2 += addresses.back().value().size();
+      }
+   } );
+
+   std::cout << "\n Creating " << table_size << " constant addresses (" << repetitions
+             << " repetitions)\n"
+             << "  Validating constructor: " << validating << "s\n"
+             << "  _email literals:        " << literals << "s\n\n";
+
+   if( checksum1 != checksum2 ) {
+      std::cerr << " RESULTS DIFFER!\n";
+   }
+
+   return EXIT_SUCCESS;
+}
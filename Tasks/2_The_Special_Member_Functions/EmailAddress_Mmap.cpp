@@ -0,0 +1,403 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Mmap.cpp
+* \brief C++ Training - Example for the validation of memory-mapped email address lists (POSIX)
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the validation of a file of email addresses via 'std::getline()' and the
+*       'EmailAddress' constructor with the in-place validation of the memory-mapped file. Which
+*       allocations and copies does the memory-mapped version avoid?
+*
+*       Usage: EmailAddress_Mmap <input> [<valid output> <invalid output>]
+*
+*       Validates every line of the given file and writes the (1-based) line numbers of the valid
+*       and invalid addresses to the given output files. Without arguments, a temporary file is
+*       created and both approaches are benchmarked.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   State state{ State::Start };
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return false;
+   }
+   return state == State::Tld;
+}
+
+} // namespace dfa
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::is_email_address( address_ ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <MappedFile.h> -----------------------------------------------------------------------------
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mapping of an entire file, which is advised for sequential access
+class MappedFile
+{
+ public:
+   explicit MappedFile( std::string const& path )
+   {
+      int const fd = ::open( path.c_str(), O_RDONLY );
+      if( fd < 0 ) {
+         throw std::system_error( errno, std::generic_category(), "Cannot open '" + path + "'" );
+      }
+
+      struct stat info{};
+      if( ::fstat( fd, &info ) != 0 ) {
+         int const error{ errno };
+         ::close( fd );
+         throw std::system_error( error, std::generic_category(), "Cannot stat '" + path + "'" );
+      }
+
+      size_ = static_cast<std::size_t>( info.st_size );
+
+      if( size_ > 0UL ) {
+         void* const ptr = ::mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+         if( ptr == MAP_FAILED ) {
+            int const error{ errno };
+            ::close( fd );
+            throw std::system_error( error, std::generic_category(), "Cannot map '" + path + "'" );
+         }
+         ::madvise( ptr, size_, MADV_SEQUENTIAL );
+         data_ = static_cast<char const*>( ptr );
+      }
+
+      ::close( fd );  // The mapping stays valid after closing the file descriptor
+   }
+
+   ~MappedFile()
+   {
+      if( data_ != nullptr ) {
+         ::munmap( const_cast<char*>( data_ ), size_ );
+      }
+   }
+
+   MappedFile( MappedFile const& ) = delete;
+   MappedFile& operator=( MappedFile const& ) = delete;
+
+   std::string_view view() const noexcept { return { data_, size_ }; }
+
+ private:
+   char const* data_{ nullptr };
+   std::size_t size_{ 0UL };
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <MappedFile.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+
+
+// Output file with a large buffer, which writes one line number per line. 'close()' reports
+// any write error; the destructor only closes the file without reporting errors.
+class LineNumberWriter
+{
+ public:
+   explicit LineNumberWriter( std::string const& path )
+      : path_{ path }
+      , file_{ std::fopen( path.c_str(), "w" ) }
+   {
+      if( file_ == nullptr ) {
+         throw std::system_error( errno, std::generic_category(), "Cannot open '" + path + "'" );
+      }
+      buffer_.reserve( capacity );
+   }
+
+   void write( std::size_t line )
+   {
+      buffer_ += std::to_string( line );
+      buffer_ += '\n';
+      if( buffer_.size() >= capacity ) flush();
+   }
+
+   void close()
+   {
+      flush();
+      if( std::fclose( file_.release() ) != 0 ) {
+         throw std::system_error( errno, std::generic_category(), "Cannot close '" + path_ + "'" );
+      }
+   }
+
+ private:
+   static constexpr std::size_t capacity{ 1UL << 20 };
+
+   struct Closer
+   {
+      void operator()( std::FILE* file ) const noexcept { std::fclose( file ); }
+   };
+
+   void flush()
+   {
+      if( std::fwrite( buffer_.data(), 1UL, buffer_.size(), file_.get() ) != buffer_.size() ) {
+         throw std::system_error( errno, std::generic_category(), "Cannot write '" + path_ + "'" );
+      }
+      buffer_.clear();
+   }
+
+   std::string path_;
+   std::unique_ptr<std::FILE,Closer> file_;
+   std::string buffer_{};
+};
+
+struct Counts
+{
+   std::size_t valid{ 0UL };
+   std::size_t invalid{ 0UL };
+};
+
+// Validates every line of the mapped file in place. The given callable is invoked with the
+// (1-based) line number and the validation result of every line. A trailing '\r' is ignored.
+template< typename Callable >
+Counts validate_mapped( std::string const& path, Callable callable )
+{
+   MappedFile const file{ path };
+   std::string_view text{ file.view() };
+
+   Counts counts{};
+   std::size_t line{ 0UL };
+
+   while( !text.empty() ) {
+      std::size_t const eol{ std::min( text.find( '\n' ), text.size() ) };
+      std::string_view address{ text.substr( 0UL, eol ) };
+      if( !address.empty() && address.back() == '\r' ) address.remove_suffix( 1UL );
+
+      bool const valid{ dfa::is_email_address( address ) };
+      ++( valid ? counts.valid : counts.invalid );
+      callable( ++line, valid );
+
+      text.remove_prefix( std::min( eol+1UL, text.size() ) );
+   }
+
+   return counts;
+}
+
+// Reference implementation: one 'std::string' and one 'EmailAddress' per line
+Counts validate_getline( std::string const& path )
+{
+   std::ifstream file{ path };
+   Counts counts{};
+
+   for( std::string line; std::getline( file, line ); ) {
+      try {
+         EmailAddress const address{ line };
+         ++counts.valid;
+      }
+      catch( std::invalid_argument const& ex ) {
+         ++counts.invalid;
+      }
+   }
+
+   return counts;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+// Creates an empty file with a unique name in the temporary directory and returns its path
+std::string create_temporary_file()
+{
+   std::string path{
+      ( std::filesystem::temp_directory_path() / "email_addresses_XXXXXX" ).string() };
+   int const fd{ ::mkstemp( path.data() ) };
+   if( fd == -1 ) {
+      throw std::system_error( errno, std::generic_category(), "Cannot create '" + path + "'" );
+   }
+   ::close( fd );
+   return path;
+}
+
+void create_file( std::string const& path, std::size_t n )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk" };
+   static constexpr char const* defects[] =
+      { "", "", "", "", "", "", "", "..", "@", "-" };
+
+   std::mt19937 rng{ 42U };
+   std::ofstream file{ path };
+   for( std::size_t i=0UL; i<n; ++i ) {
+      file << locals[rng()%5U] << rng()%10000U << defects[rng()%10U] << '@'
+           << domains[rng()%3U] << '\n';
+   }
+}
+
+
+int main( int argc, char** argv )
+{
+   try {
+      if( argc == 2 || argc == 4 )
+      {
+         std::string const input{ argv[1] };
+         Counts counts{};
+
+         double const seconds = benchmark( [&]{
+            if( argc == 4 ) {
+               LineNumberWriter valid{ argv[2] };
+               LineNumberWriter invalid{ argv[3] };
+               counts = validate_mapped( input, [&]( std::size_t line, bool ok ){
+                  ( ok ? valid : invalid ).write( line );
+               } );
+               valid.close();
+               invalid.close();
+            }
+            else {
+               counts = validate_mapped( input, []( std::size_t, bool ){} );
+            }
+         } );
+
+         std::cout << counts.valid << " valid, " << counts.invalid << " invalid ("
+                   << seconds << "s)\n";
+      }
+      else if( argc == 1 )
+      {
+         constexpr std::size_t N( 5000000UL );
+
+         std::string const path{ create_temporary_file() };
+         create_file( path, N );
+
+         std::cout << "\n Validating " << N << " addresses ("
+                   << std::filesystem::file_size( path ) / 1e6 << " MB)\n";
+
+         Counts reference{}, mapped{};
+         double const t1 = benchmark( [&]{ reference = validate_getline( path ); } );
+         double const t2 = benchmark( [&]{
+            mapped = validate_mapped( path, []( std::size_t, bool ){} );
+         } );
+
+         std::cout << "  std::getline() + EmailAddress: " << t1 << "s (" << reference.valid
+                   << " valid)\n"
+                   << "  mmap() + string_view:          " << t2 << "s (" << mapped.valid
+                   << " valid)\n\n";
+
+         if( reference.valid != mapped.valid || reference.invalid != mapped.invalid ) {
+            std::cerr << " RESULTS DIFFER!\n";
+         }
+
+         std::filesystem::remove( path );
+      }
+      else
+      {
+         std::cerr << "Usage: " << argv[0] << " <input> [<valid output> <invalid output>]\n";
+         return EXIT_FAILURE;
+      }
+   }
+   catch( std::exception const& ex ) {
+      std::cerr << ex.what() << "\n";
+      return EXIT_FAILURE;
+   }
+
+   return EXIT_SUCCESS;
+}
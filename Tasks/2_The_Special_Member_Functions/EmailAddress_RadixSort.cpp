@@ -0,0 +1,572 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_RadixSort.cpp
+* \brief C++ Training - Example for a parallel MSD radix sort of email addresses
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the runtime of sorting email addresses by domain and removing all duplicates
+*       via 'std::sort()' and 'std::unique()', via a parallel 'std::sort()', and via a parallel
+*       MSD radix sort of (key prefix, index) pairs. Why does the radix sort not need to move
+*       a single 'std::string'?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+struct Result
+{
+   bool valid{ false };
+   std::size_t at{ 0UL };   // Position of the '@'
+   std::size_t dot{ 0UL };  // Position of the last dot (i.e. the dot in front of the TLD)
+};
+
+// Validates the given address in a single left-to-right pass and records the position of the
+// '@' and of the last dot on the way
+constexpr Result validate( std::string_view address ) noexcept
+{
+   Result result{};
+   State state{ State::Start };
+
+   for( std::size_t i=0UL; i<address.size(); ++i )
+   {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( address[i] )])];
+
+      if( state == State::Reject ) {
+         return result;
+      }
+      if( state == State::At ) {
+         result.at = i;
+      }
+      else if( state == State::TldStart ) {
+         result.dot = i;
+      }
+   }
+
+   result.valid = ( state == State::Tld );
+   return result;
+}
+
+} // namespace dfa
+
+
+static_assert( dfa::validate( "klaus.iglberger@gmx.de" ).at == 15UL );
+static_assert( dfa::validate( "klaus.iglberger@gmx.de" ).dot == 19UL );
+static_assert( dfa::validate( "k_i@mail.server.co.uk" ).dot == 18UL );
+
+
+// Email address, which remembers the position of the '@' and of the dot in front of the
+// top-level domain. Since the positions are found during validation anyway, the local part,
+// the domain and the top-level domain are available in O(1).
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( address_.size() > std::numeric_limits<std::uint16_t>::max() ) {
+         throw std::invalid_argument( "Email address too long" );
+      }
+
+      dfa::Result const result{ dfa::validate( address_ ) };
+      if( !result.valid ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+
+      at_  = static_cast<std::uint16_t>( result.at );
+      dot_ = static_cast<std::uint16_t>( result.dot );
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::validate( address_ ).valid; }
+
+   // "klaus.iglberger" for "klaus.iglberger@mail.server.co.uk"
+   std::string_view local_part() const noexcept
+   {
+      return std::string_view{ address_ }.substr( 0UL, at_ );
+   }
+
+   // "mail.server.co.uk" for "klaus.iglberger@mail.server.co.uk"
+   std::string_view domain() const noexcept
+   {
+      return std::string_view{ address_ }.substr( at_+1UL );
+   }
+
+   // "uk" for "klaus.iglberger@mail.server.co.uk"
+   std::string_view tld() const noexcept
+   {
+      return std::string_view{ address_ }.substr( dot_+1UL );
+   }
+
+ private:
+   std::string address_;
+   std::uint16_t at_{};   // Position of the '@'
+   std::uint16_t dot_{};  // Position of the dot in front of the top-level domain
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <RadixSort.h> ------------------------------------------------------------------------------
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Sorts email addresses by (reversed domain, local part) and removes all duplicates. The sort
+// key of every address is written once into a contiguous buffer (e.g. "uk.co.server.mail\1klaus"
+// for "klaus@mail.server.co.uk"); the separator '\1' sorts in front of all valid characters,
+// such that all addresses of a domain precede the addresses of its subdomains. The radix sort
+// itself only moves 16-byte (prefix, index) pairs, where the prefix holds the next 8 bytes of
+// the key in big-endian order. Duplicates are detected whenever a bucket consists of keys that
+// have ended, i.e. unique is fused into the sort.
+class RadixSorter
+{
+ public:
+   explicit RadixSorter( std::size_t threads )
+      : threads_{ std::max( threads, 1UL ) }
+   {}
+
+   std::vector<EmailAddress> operator()( std::span<EmailAddress const> addresses )
+   {
+      build_keys( addresses );
+      sort_parallel();
+
+      std::vector<EmailAddress> result{};
+      result.reserve( entries_.size() );
+      for( Entry const& e : entries_ ) {
+         if( !e.duplicate ) result.push_back( addresses[e.index] );
+      }
+      return result;
+   }
+
+ private:
+   static constexpr char separator{ '\1' };
+   static constexpr std::size_t small{ 32UL };  // Buckets up to this size are comparison sorted
+
+   struct Entry
+   {
+      std::uint64_t prefix;
+      std::uint32_t index;
+      bool duplicate;
+   };
+
+   struct Task
+   {
+      Entry* first;
+      Entry* last;
+      Entry* buffer;
+      std::size_t depth;  // Position of the prefix within the key
+      std::size_t byte;   // Byte of the prefix to distribute by
+   };
+
+   std::string_view key( std::uint32_t index ) const noexcept
+   {
+      return { keys_.data()+offsets_[index], offsets_[index+1U]-offsets_[index] };
+   }
+
+   // Returns the 8 key bytes starting at 'depth' in big-endian order, padded with zeros
+   std::uint64_t load( std::uint32_t index, std::size_t depth ) const noexcept
+   {
+      std::string_view const k{ key( index ) };
+      unsigned char bytes[8]{};
+      if( depth < k.size() ) {
+         std::memcpy( bytes, k.data()+depth, std::min( k.size()-depth, 8UL ) );
+      }
+
+      std::uint64_t prefix{ 0U };
+      for( unsigned char const b : bytes ) {
+         prefix = ( prefix << 8 ) | b;
+      }
+      return prefix;
+   }
+
+   // Writes the domain labels from right to left, the separator and the local part; the key
+   // has the same length as the address
+   static void write_key( EmailAddress const& address, char* out ) noexcept
+   {
+      std::string_view domain{ address.domain() };
+      for( ;; ) {
+         std::size_t const dot{ domain.rfind( '.' ) };
+         std::string_view const label{ dot == std::string_view::npos ? domain
+                                                                      : domain.substr( dot+1UL ) };
+         out = std::copy( label.begin(), label.end(), out );
+         if( dot == std::string_view::npos ) break;
+         *out++ = '.';
+         domain = domain.substr( 0UL, dot );
+      }
+      *out++ = separator;
+      std::string_view const local{ address.local_part() };
+      std::copy( local.begin(), local.end(), out );
+   }
+
+   void build_keys( std::span<EmailAddress const> addresses )
+   {
+      if( addresses.size() > std::numeric_limits<std::uint32_t>::max() ) {
+         throw std::length_error( "Too many email addresses" );
+      }
+
+      offsets_.resize( addresses.size()+1UL );
+      offsets_[0] = 0UL;
+      for( std::size_t i=0UL; i<addresses.size(); ++i ) {
+         offsets_[i+1UL] = offsets_[i] + addresses[i].value().size();
+      }
+      keys_.resize( offsets_.back() );
+      entries_.resize( addresses.size() );
+      buffer_.resize( addresses.size() );
+
+      // Every thread writes the keys and the initial prefixes of a disjoint range
+      std::vector<std::jthread> workers{};
+      for( std::size_t t=0UL; t<threads_; ++t ) {
+         workers.emplace_back( [&,t]{
+            std::size_t const begin{ addresses.size() *  t      / threads_ };
+            std::size_t const end  { addresses.size() * (t+1UL) / threads_ };
+            for( std::size_t i=begin; i<end; ++i ) {
+               auto const index = static_cast<std::uint32_t>( i );
+               write_key( addresses[i], keys_.data()+offsets_[i] );
+               entries_[i] = Entry{ load( index, 0UL ), index, false };
+            }
+         } );
+      }
+   }
+
+   // Marks all but the first entry as duplicates; only called for identical keys
+   static void mark_duplicates( Entry* first, Entry* last ) noexcept
+   {
+      for( ; first != last && ++first != last; ) {
+         first->duplicate = true;
+      }
+   }
+
+   // Sorts a small range by comparing the remaining keys and marks adjacent duplicates
+   void sort_small( Entry* first, Entry* last, std::size_t depth ) const
+   {
+      auto const rest = [&]( Entry const& e ){ return key( e.index ).substr( depth ); };
+
+      std::sort( first, last, [&]( Entry const& a, Entry const& b ){ return rest( a ) < rest( b ); } );
+      for( Entry* e=first+1; e<last; ++e ) {
+         e->duplicate = ( rest( *e ) == rest( *(e-1) ) );
+      }
+   }
+
+   // Distributes the given range by a single byte of the prefix and passes every bucket,
+   // which needs further sorting, to 'recurse'. The keys in bucket 0 have ended and are equal.
+   template< typename Recurse >
+   void distribute( Task const& task, Recurse recurse )
+   {
+      auto const [first, last, buffer, depth, byte] = task;
+      std::size_t const n( last - first );
+      unsigned const shift( 56U - 8U*byte );
+
+      std::array<std::size_t,257UL> bounds{};
+      for( Entry const* e=first; e<last; ++e ) {
+         ++bounds[( ( e->prefix >> shift ) & 0xFFU ) + 1UL];
+      }
+
+      // Scattering is only necessary if the entries fall into more than one bucket
+      if( std::find( bounds.begin(), bounds.end(), n ) == bounds.end() ) {
+         for( std::size_t b=1UL; b<257UL; ++b ) bounds[b] += bounds[b-1UL];
+         std::array<std::size_t,257UL> next{ bounds };
+         for( Entry const* e=first; e<last; ++e ) {
+            buffer[next[( e->prefix >> shift ) & 0xFFU]++] = *e;
+         }
+         std::copy( buffer, buffer+n, first );
+      }
+      else {
+         std::size_t const b( std::find( bounds.begin(), bounds.end(), n ) - bounds.begin() );
+         std::fill( bounds.begin(), bounds.begin()+b, 0UL );
+         std::fill( bounds.begin()+b, bounds.end(), n );
+      }
+
+      mark_duplicates( first, first+bounds[1] );
+
+      for( std::size_t b=1UL; b<256UL; ++b ) {
+         Entry* const f{ first+bounds[b] };
+         Entry* const l{ first+bounds[b+1UL] };
+         if( l-f < 2 ) continue;
+
+         if( byte < 7UL ) {
+            recurse( Task{ f, l, buffer+bounds[b], depth, byte+1UL } );
+         }
+         else {
+            for( Entry* e=f; e<l; ++e ) e->prefix = load( e->index, depth+8UL );
+            recurse( Task{ f, l, buffer+bounds[b], depth+8UL, 0UL } );
+         }
+      }
+   }
+
+   void sort( Task const& task )
+   {
+      if( task.last - task.first <= std::ptrdiff_t(small) ) {
+         sort_small( task.first, task.last, task.depth );
+      }
+      else {
+         distribute( task, [this]( Task const& t ){ sort( t ); } );
+      }
+   }
+
+   // Large buckets are distributed by the thread that picks them up and the resulting buckets
+   // are handed back to the task pool; small buckets are sorted recursively by a single thread
+   void sort_parallel()
+   {
+      std::size_t const grain{ std::max( entries_.size() / ( 8UL*threads_ ), small ) };
+
+      std::mutex mutex{};
+      std::condition_variable cv{};
+      std::vector<Task> tasks{ Task{ entries_.data(), entries_.data()+entries_.size(),
+                                     buffer_.data(), 0UL, 0UL } };
+      std::size_t pending{ 1UL };
+
+      auto const push = [&]( Task const& t ) {
+         {
+            std::lock_guard lock{ mutex };
+            tasks.push_back( t );
+            ++pending;
+         }
+         cv.notify_one();
+      };
+
+      std::vector<std::jthread> workers{};
+      for( std::size_t t=0UL; t<threads_; ++t ) {
+         workers.emplace_back( [&]{
+            for( ;; ) {
+               std::unique_lock lock{ mutex };
+               cv.wait( lock, [&]{ return !tasks.empty() || pending == 0UL; } );
+               if( tasks.empty() ) return;
+               Task const task{ tasks.back() };
+               tasks.pop_back();
+               lock.unlock();
+
+               if( std::size_t( task.last - task.first ) > grain ) {
+                  distribute( task, push );
+               }
+               else {
+                  sort( task );
+               }
+
+               lock.lock();
+               if( --pending == 0UL ) cv.notify_all();
+            }
+         } );
+      }
+   }
+
+   std::size_t threads_;
+   std::string keys_{};
+   std::vector<std::size_t> offsets_{};
+   std::vector<Entry> entries_{};
+   std::vector<Entry> buffer_{};
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <RadixSort.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+
+// Creates 'n' addresses, of which approximately 90% are duplicates
+std::vector<EmailAddress> create_addresses( std::size_t n )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk", "server.co.uk", "web.de" };
+
+   std::mt19937 rng{ 42U };
+   std::vector<EmailAddress> addresses{};
+   addresses.reserve( n );
+   for( std::size_t i=0UL; i<n; ++i ) {
+      addresses.emplace_back( std::string{ locals[rng()%5U] } + std::to_string( rng()%( n/250U ) ) +
+                              '@' + domains[rng()%5U] );
+   }
+   return addresses;
+}
+
+// Orders by the domain labels from right to left, then by the local part (i.e. the same order
+// as the keys of the radix sort), without building any key
+bool domain_order( EmailAddress const& lhs, EmailAddress const& rhs )
+{
+   std::string_view d1{ lhs.domain() };
+   std::string_view d2{ rhs.domain() };
+
+   while( !d1.empty() && !d2.empty() ) {
+      std::size_t const p1{ d1.rfind( '.' ) };
+      std::size_t const p2{ d2.rfind( '.' ) };
+      std::size_t const b1{ p1 == std::string_view::npos ? 0UL : p1+1UL };
+      std::size_t const b2{ p2 == std::string_view::npos ? 0UL : p2+1UL };
+
+      if( int const cmp = d1.substr( b1 ).compare( d2.substr( b2 ) ); cmp != 0 ) {
+         return cmp < 0;
+      }
+      d1 = d1.substr( 0UL, b1 == 0UL ? 0UL : p1 );
+      d2 = d2.substr( 0UL, b2 == 0UL ? 0UL : p2 );
+   }
+
+   if( d1.empty() != d2.empty() ) return d1.empty();
+   return lhs.local_part() < rhs.local_part();
+}
+
+bool same_value( EmailAddress const& lhs, EmailAddress const& rhs )
+{
+   return lhs.value() == rhs.value();
+}
+
+// Sorts 'threads' chunks concurrently and merges them pairwise (fork-join)
+void parallel_sort( std::vector<EmailAddress>& addresses, std::size_t threads )
+{
+   std::vector<std::size_t> bounds{};
+   for( std::size_t t=0UL; t<=threads; ++t ) {
+      bounds.push_back( addresses.size() * t / threads );
+   }
+
+   {
+      std::vector<std::jthread> workers{};
+      for( std::size_t t=0UL; t<threads; ++t ) {
+         workers.emplace_back( [&,t]{
+            std::sort( addresses.begin()+bounds[t], addresses.begin()+bounds[t+1UL], domain_order );
+         } );
+      }
+   }
+
+   for( std::size_t width=1UL; width<threads; width*=2UL )
+   {
+      std::vector<std::jthread> workers{};
+      for( std::size_t t=0UL; t+width<threads; t+=2UL*width ) {
+         workers.emplace_back( [&,t]{
+            std::inplace_merge( addresses.begin()+bounds[t], addresses.begin()+bounds[t+width],
+                                addresses.begin()+bounds[std::min( t+2UL*width, threads )],
+                                domain_order );
+         } );
+      }
+   }
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 2000000UL );
+
+   std::size_t const threads{ std::max( 4U, std::thread::hardware_concurrency() ) };
+
+   std::vector<EmailAddress> const addresses{ create_addresses( N ) };
+
+   std::vector<EmailAddress> result1{}, result2{}, result3{};
+
+   double const serial = benchmark( [&]{
+      result1 = addresses;
+      std::sort( result1.begin(), result1.end(), domain_order );
+      result1.erase( std::unique( result1.begin(), result1.end(), same_value ), result1.end() );
+   } );
+
+   double const parallel = benchmark( [&]{
+      result2 = addresses;
+      parallel_sort( result2, threads );
+      result2.erase( std::unique( result2.begin(), result2.end(), same_value ), result2.end() );
+   } );
+
+   double const radix = benchmark( [&]{
+      result3 = RadixSorter{ threads }( addresses );
+   } );
+
+   std::cout << "\n Sorting " << N << " email addresses by domain (" << result1.size() << " unique)\n"
+             << "  std::sort() + std::unique():           " << serial   << "s\n"
+             << "  Parallel std::sort() (" << threads << " threads):      " << parallel << "s\n"
+             << "  Parallel radix sort with fused unique: " << radix    << "s\n";
+
+   std::cout << "\n First addresses:";
+   for( std::size_t i=0UL; i<3UL && i<result3.size(); ++i ) {
+      std::cout << " " << result3[i].value();
+   }
+   std::cout << "\n\n";
+
+   if( !std::equal( result1.begin(), result1.end(), result2.begin(), result2.end(), same_value ) ||
+       !std::equal( result1.begin(), result1.end(), result3.begin(), result3.end(), same_value ) ) {
+      std::cerr << " RESULTS DIFFER!\n";
+   }
+
+   return EXIT_SUCCESS;
+}
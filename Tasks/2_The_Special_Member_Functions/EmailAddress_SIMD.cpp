@@ -0,0 +1,429 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_SIMD.cpp
+* \brief C++ Training - Example for the SIMD vectorization of the email address validation
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the throughput of the scalar 'is_email_address()' function with the SSE2 and
+*       AVX2 kernels, which classify 16 and 32 characters at once. Convince yourself that all
+*       kernels yield the same result as the scalar reference. Note that the benchmark should be
+*       compiled with optimizations (e.g. '-O2').
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define EMAIL_SIMD_X86 1
+#endif
+
+template< typename RandomAccessIt >
+constexpr bool is_valid_email_part( RandomAccessIt first, RandomAccessIt last )
+{
+   auto const isalnum_or_dots_or_underscore =
+      []( char a ){ return isalnum(a) || a == '.' || a == '_'; };
+
+   auto const adjacent_dots =
+      []( char a, char b ){ return a == '.' && b == '.'; };
+
+   return first != last &&
+          std::all_of( first, last, isalnum_or_dots_or_underscore ) &&
+          std::adjacent_find( first, last, adjacent_dots ) == last &&
+          *first != '.' &&
+          *(last-1) != '.';
+}
+
+template< typename RandomAccessIt >
+constexpr bool is_email_address( RandomAccessIt first, RandomAccessIt last )
+{
+   auto const firstAt = std::find( first, last, '@' );
+   auto const firstDotAfterAt = std::find( firstAt, last, '.' );
+
+   return firstAt != last &&
+          firstDotAfterAt != last &&
+          is_valid_email_part( first, firstAt ) &&
+          is_valid_email_part( firstAt+1, firstDotAfterAt ) &&
+          is_valid_email_part( firstDotAfterAt+1, last );
+
+}
+
+
+//---- <EmailAddressSIMD.h> -----------------------------------------------------------------------
+
+namespace simd {
+
+// Classification of a block of 64 characters: bit i of each mask refers to character i
+struct BlockMasks
+{
+   std::uint64_t at;   // '@'
+   std::uint64_t dot;  // '.'
+   std::uint64_t bad;  // Neither alphanumeric nor '.', '_', or '@'
+};
+
+using Classifier = BlockMasks(*)( char const* ) noexcept;
+
+// Validates an email address based on the block classification of the given 'classify' function.
+// The rules of 'is_email_address()' are equivalent to the following conditions:
+//  - the address consists of alphanumeric characters, '.', '_', and exactly one '@';
+//  - the address does not contain two adjacent dots;
+//  - the local part is not empty and neither starts nor ends with a dot;
+//  - there is a dot after the '@', which is neither the first character after the '@' nor the
+//    last character of the address.
+template< Classifier classify >
+inline bool is_email_address( std::string_view address ) noexcept
+{
+   constexpr std::size_t npos{ std::string_view::npos };
+
+   std::size_t const size{ address.size() };
+   std::size_t at{ npos };
+   std::size_t dot{ npos };
+   std::uint64_t previousDot{ 0U };
+
+   alignas(64) char tail[64];
+
+   for( std::size_t base=0UL; base<size; base+=64UL )
+   {
+      std::size_t const remaining{ size - base };
+      BlockMasks m{};
+
+      if( remaining >= 64UL ) {
+         m = classify( address.data()+base );
+      }
+      else {
+         std::memset( tail, 0, sizeof(tail) );
+         std::memcpy( tail, address.data()+base, remaining );
+         m = classify( tail );
+         std::uint64_t const valid{ ( std::uint64_t{1} << remaining ) - 1U };
+         m.at &= valid;
+         m.dot &= valid;
+         m.bad &= valid;
+      }
+
+      if( m.bad != 0U || ( m.dot & ( ( m.dot << 1 ) | previousDot ) ) != 0U ) {
+         return false;
+      }
+      previousDot = m.dot >> 63;
+
+      if( m.at != 0U ) {
+         if( at != npos || ( m.at & ( m.at-1U ) ) != 0U ) {
+            return false;  // More than one '@'
+         }
+         at = base + std::countr_zero( m.at );
+         std::uint64_t const dotsAfterAt{ m.dot & ~( ( m.at << 1 ) - 1U ) };
+         if( dotsAfterAt != 0U ) {
+            dot = base + std::countr_zero( dotsAfterAt );
+         }
+      }
+      else if( at != npos && dot == npos && m.dot != 0U ) {
+         dot = base + std::countr_zero( m.dot );
+      }
+   }
+
+   return at != npos && dot != npos &&
+          at > 0UL && address[0] != '.' && address[at-1UL] != '.' &&
+          dot > at+1UL && dot+1UL < size && address[size-1UL] != '.';
+}
+
+// Scalar classification (for platforms without SIMD support and as reference for the kernels)
+inline BlockMasks classify_scalar( char const* block ) noexcept
+{
+   BlockMasks m{};
+   for( std::size_t i=0UL; i<64UL; ++i ) {
+      unsigned char const c( block[i] );
+      std::uint64_t const bit{ std::uint64_t{1} << i };
+      unsigned char const lower( c | 0x20 );
+      bool const alnum = ( c >= '0' && c <= '9' ) || ( lower >= 'a' && lower <= 'z' );
+      if( c == '@' ) m.at |= bit;
+      if( c == '.' ) m.dot |= bit;
+      if( !alnum && c != '.' && c != '_' && c != '@' ) m.bad |= bit;
+   }
+   return m;
+}
+
+#if EMAIL_SIMD_X86
+
+// SSE2 kernel: 16 characters per instruction; the character ranges are checked via unsigned
+// minimum/maximum comparisons (SSE2 has no unsigned byte comparison)
+inline BlockMasks classify_sse2( char const* block ) noexcept
+{
+   auto const in_range = []( __m128i v, char lo, char hi ) {
+      return _mm_and_si128( _mm_cmpeq_epi8( _mm_max_epu8( v, _mm_set1_epi8( lo ) ), v ),
+                            _mm_cmpeq_epi8( _mm_min_epu8( v, _mm_set1_epi8( hi ) ), v ) );
+   };
+
+   BlockMasks m{};
+
+   for( std::size_t i=0UL; i<4UL; ++i )
+   {
+      __m128i const v = _mm_loadu_si128( reinterpret_cast<__m128i const*>( block + 16UL*i ) );
+
+      __m128i const at    = _mm_cmpeq_epi8( v, _mm_set1_epi8( '@' ) );
+      __m128i const dot   = _mm_cmpeq_epi8( v, _mm_set1_epi8( '.' ) );
+      __m128i const under = _mm_cmpeq_epi8( v, _mm_set1_epi8( '_' ) );
+      __m128i const digit = in_range( v, '0', '9' );
+      __m128i const alpha = in_range( _mm_or_si128( v, _mm_set1_epi8( 0x20 ) ), 'a', 'z' );
+
+      __m128i const good = _mm_or_si128( _mm_or_si128( at, dot ),
+                                         _mm_or_si128( under, _mm_or_si128( digit, alpha ) ) );
+
+      unsigned const shift( 16U*i );
+      m.at  |= std::uint64_t( unsigned( _mm_movemask_epi8( at ) ) ) << shift;
+      m.dot |= std::uint64_t( unsigned( _mm_movemask_epi8( dot ) ) ) << shift;
+      m.bad |= std::uint64_t( unsigned( ~_mm_movemask_epi8( good ) ) & 0xFFFFU ) << shift;
+   }
+
+   return m;
+}
+
+// AVX2 kernel: 32 characters per instruction; the valid characters are classified via two
+// 16-entry lookup tables (indexed by the low and high nibble of each character), which are
+// evaluated via 'vpshufb'. A character is valid if the two table entries share a bit:
+//   bit 0: '.'          (0x2E)          bit 3: 'P'-'Z','p'-'z' (0x50-0x5A, 0x70-0x7A)
+//   bit 1: '0'-'9'      (0x30-0x39)     bit 4: '_'          (0x5F)
+//   bit 2: '@','A'-'O'  (0x40-0x4F)     bit 5: 'a'-'o'      (0x61-0x6F)
+__attribute__(( target( "avx2" ) ))
+inline BlockMasks classify_avx2( char const* block ) noexcept
+{
+   __m256i const lo_table = _mm256_setr_epi8(
+      0x0E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2C,0x24,0x24,0x24,0x25,0x34,
+      0x0E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2E,0x2C,0x24,0x24,0x24,0x25,0x34 );
+   __m256i const hi_table = _mm256_setr_epi8(
+      0x00,0x00,0x01,0x02,0x04,0x18,0x20,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+      0x00,0x00,0x01,0x02,0x04,0x18,0x20,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 );
+   __m256i const nibble = _mm256_set1_epi8( 0x0F );
+
+   BlockMasks m{};
+
+   for( std::size_t i=0UL; i<2UL; ++i )
+   {
+      __m256i const v = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( block + 32UL*i ) );
+
+      __m256i const lo = _mm256_shuffle_epi8( lo_table, _mm256_and_si256( v, nibble ) );
+      __m256i const hi = _mm256_shuffle_epi8( hi_table,
+                            _mm256_and_si256( _mm256_srli_epi16( v, 4 ), nibble ) );
+      __m256i const bad = _mm256_cmpeq_epi8( _mm256_and_si256( lo, hi ), _mm256_setzero_si256() );
+
+      __m256i const at  = _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '@' ) );
+      __m256i const dot = _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '.' ) );
+
+      unsigned const shift( 32U*i );
+      m.at  |= std::uint64_t( unsigned( _mm256_movemask_epi8( at ) ) ) << shift;
+      m.dot |= std::uint64_t( unsigned( _mm256_movemask_epi8( dot ) ) ) << shift;
+      m.bad |= std::uint64_t( unsigned( _mm256_movemask_epi8( bad ) ) ) << shift;
+   }
+
+   return m;
+}
+
+__attribute__(( target( "avx2" ) ))
+inline bool is_email_address_avx2( std::string_view address ) noexcept
+{
+   return is_email_address<classify_avx2>( address );
+}
+
+inline bool is_email_address_sse2( std::string_view address ) noexcept
+{
+   return is_email_address<classify_sse2>( address );
+}
+
+#endif
+
+inline bool is_email_address_scalar( std::string_view address ) noexcept
+{
+   return is_email_address<classify_scalar>( address );
+}
+
+using Kernel = bool(*)( std::string_view ) noexcept;
+
+// Selects the best available kernel at runtime, based on the features of the CPU
+inline Kernel select_kernel() noexcept
+{
+#if EMAIL_SIMD_X86
+   __builtin_cpu_init();
+   if( __builtin_cpu_supports( "avx2" ) ) {
+      return is_email_address_avx2;
+   }
+   return is_email_address_sse2;
+#else
+   return is_email_address_scalar;
+#endif
+}
+
+inline bool is_email_address( std::string_view address ) noexcept
+{
+   static Kernel const kernel{ select_kernel() };
+   return kernel( address );
+}
+
+} // namespace simd
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return simd::is_email_address( address_ ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+bool reference( std::string_view address )
+{
+   return ::is_email_address( address.begin(), address.end() );
+}
+
+// Random strings over an alphabet, which provokes all rules of 'is_valid_email_part()'
+std::vector<std::string> random_strings( std::size_t n, std::size_t max_length )
+{
+   static constexpr char alphabet[] = "aZ9_..@@-+ \x80";
+
+   std::mt19937 rng{ 42U };
+   std::uniform_int_distribution<std::size_t> length( 0UL, max_length );
+   std::uniform_int_distribution<std::size_t> pick( 0UL, sizeof(alphabet)-2UL );
+
+   std::vector<std::string> strings( n );
+   for( auto& s : strings ) {
+      s.resize( length( rng ) );
+      for( auto& c : s ) c = alphabet[pick( rng )];
+   }
+   return strings;
+}
+
+std::vector<std::string> random_addresses( std::size_t n )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a" };
+   static constexpr char const* domains[] = { "gmx.de", "example.com", "mail.server.co.uk" };
+   static constexpr char const* breakers[] = { "", "", "", "..", "@", "-" };
+
+   std::mt19937 rng{ 7U };
+   std::vector<std::string> addresses( n );
+   for( auto& a : addresses ) {
+      a = std::string{ locals[rng()%5U] } + std::to_string( rng()%10000U )
+        + breakers[rng()%6U] + '@' + domains[rng()%3U];
+   }
+   return addresses;
+}
+
+template< typename Validate >
+void benchmark( char const* label, std::vector<std::string> const& addresses, Validate validate )
+{
+   constexpr std::size_t repetitions{ 5UL };
+
+   std::size_t bytes{ 0UL };
+   for( auto const& a : addresses ) bytes += a.size();
+
+   std::size_t valid{ 0UL };
+
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   for( std::size_t r=0UL; r<repetitions; ++r ) {
+      for( auto const& a : addresses ) {
+         valid += validate( a );
+      }
+   }
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   const double seconds( elapsedTime.count() );
+
+   std::cout << "  " << label << ": " << seconds << "s, "
+             << ( bytes*repetitions / seconds / 1e9 ) << " GB/s (" << valid/repetitions
+             << " valid)\n";
+}
+
+
+int main()
+{
+   // Cross-checking all kernels against the scalar reference
+   std::vector<std::string> inputs{ random_strings( 200000UL, 140UL ) };
+   for( auto const& a : random_addresses( 200000UL ) ) inputs.push_back( a );
+
+   std::size_t mismatches{ 0UL };
+   for( auto const& s : inputs ) {
+      bool const expected{ reference( s ) };
+      mismatches += ( simd::is_email_address_scalar( s ) != expected );
+#if EMAIL_SIMD_X86
+      mismatches += ( simd::is_email_address_sse2( s ) != expected );
+      if( __builtin_cpu_supports( "avx2" ) ) {
+         mismatches += ( simd::is_email_address_avx2( s ) != expected );
+      }
+#endif
+   }
+   std::cout << "\n Cross-check of " << inputs.size() << " inputs: " << mismatches
+             << " mismatches\n";
+   if( mismatches != 0UL ) {
+      std::cerr << " KERNELS DISAGREE WITH THE SCALAR REFERENCE!\n";
+   }
+
+   // Benchmark
+   std::vector<std::string> const addresses{ random_addresses( 1000000UL ) };
+
+   std::cout << "\n Validating " << addresses.size() << " addresses\n";
+   benchmark( "is_email_address()  ", addresses, reference );
+   benchmark( "scalar block kernel ", addresses, simd::is_email_address_scalar );
+#if EMAIL_SIMD_X86
+   benchmark( "SSE2 kernel         ", addresses, simd::is_email_address_sse2 );
+   if( __builtin_cpu_supports( "avx2" ) ) {
+      benchmark( "AVX2 kernel         ", addresses, simd::is_email_address_avx2 );
+   }
+#endif
+   benchmark( "runtime dispatch    ", addresses,
+              []( std::string_view a ){ return simd::is_email_address( a ); } );
+
+   // Construction of an email address
+   EmailAddress const address{ "klaus.iglberger@gmx.de" };
+   std::cout << "\n Email address: " << address << "\n\n";
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,401 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Scanner.cpp
+* \brief C++ Training - Example for the extraction of email addresses from free text
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the throughput of extracting email addresses from a stream of free text via
+*       'std::regex', via a scalar scanner and via a scanner, which finds the '@' characters
+*       with SSE2 instructions. Why is the search for '@' the only part worth vectorizing?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   State state{ State::Start };
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return false;
+   }
+   return state == State::Tld;
+}
+
+constexpr CharClass classify( char c ) noexcept
+{
+   return char_classes[static_cast<unsigned char>( c )];
+}
+
+} // namespace dfa
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::is_email_address( address_ ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <Scanner.h> --------------------------------------------------------------------------------
+
+#include <bit>
+#include <span>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+// Searches for the next '@' one character at a time
+struct ScalarSearch
+{
+   char const* operator()( char const* first, char const* last ) const noexcept
+   {
+      while( first != last && *first != '@' ) ++first;
+      return first;
+   }
+};
+
+#if defined(__SSE2__)
+
+// Searches for the next '@' 16 characters at a time
+struct SimdSearch
+{
+   char const* operator()( char const* first, char const* last ) const noexcept
+   {
+      __m128i const at{ _mm_set1_epi8( '@' ) };
+      for( ; last-first >= 16; first += 16 ) {
+         __m128i const v{ _mm_loadu_si128( reinterpret_cast<__m128i const*>( first ) ) };
+         auto const mask = static_cast<unsigned>( _mm_movemask_epi8( _mm_cmpeq_epi8( v, at ) ) );
+         if( mask != 0U ) return first + std::countr_zero( mask );
+      }
+      return ScalarSearch{}( first, last );
+   }
+};
+
+#else
+
+using SimdSearch = ScalarSearch;
+
+#endif
+
+
+struct Match
+{
+   std::size_t offset;        // Position of the address in the stream
+   std::string_view address;  // Only valid during the callback
+};
+
+// Extracts all valid email addresses from a stream of text, which is fed in chunks of arbitrary
+// size. Every '@' is expanded to the left and to the right as long as the characters are
+// alphanumeric, '_' or '.' (i.e. the characters of 'is_valid_email_part()'); leading dots of
+// the local part and trailing dots of the domain (e.g. at the end of a sentence) are removed
+// and the candidate is validated in place. Only the characters after the last separator of a
+// chunk are copied into the next one, since an address cannot span a separator.
+template< typename Search >
+class BasicScanner
+{
+ public:
+   template< typename Callable >
+   void feed( std::span<char const> chunk, Callable callable )
+   {
+      std::string_view const text( chunk.data(), chunk.size() );
+
+      auto const first = std::find_if( text.begin(), text.end(), is_separator );
+      if( first == text.end() ) {
+         carry_.append( text );
+         if( carry_.size() > max_carry ) carry_.erase( 0UL, carry_.size()-max_carry );
+         position_ += text.size();
+         return;
+      }
+
+      // The characters from the carry up to the first separator
+      std::size_t const start{ position_ - carry_.size() };
+      carry_.append( text.begin(), first );
+      scan( carry_, start, callable );
+
+      // The characters in between the first and the last separator, in place
+      auto const last = std::find_if( text.rbegin(), text.rend(), is_separator ).base();
+      std::size_t const begin( first - text.begin() );
+      std::size_t const end( last - text.begin() );
+      scan( text.substr( begin, end-begin ), position_+begin, callable );
+
+      carry_.assign( last, text.end() );
+      position_ += text.size();
+   }
+
+   template< typename Callable >
+   void finish( Callable callable )
+   {
+      scan( carry_, position_-carry_.size(), callable );
+      carry_.clear();
+   }
+
+ private:
+   static constexpr std::size_t max_carry{ 1UL << 16 };
+
+   static bool is_part( char c ) noexcept
+   {
+      dfa::CharClass const cc{ dfa::classify( c ) };
+      return cc == dfa::CharClass::Word || cc == dfa::CharClass::Dot;
+   }
+
+   static bool is_separator( char c ) noexcept
+   {
+      return dfa::classify( c ) == dfa::CharClass::Other;
+   }
+
+   template< typename Callable >
+   static void scan( std::string_view region, std::size_t offset, Callable& callable )
+   {
+      char const* const begin{ region.data() };
+      char const* const end{ region.data() + region.size() };
+      char const* floor{ begin };  // End of the previous candidate
+
+      for( char const* at=Search{}( begin, end ); at != end; at=Search{}( floor, end ) )
+      {
+         char const* first{ at };
+         while( first > floor && is_part( first[-1] ) ) --first;
+         char const* last{ at+1 };
+         while( last < end && is_part( *last ) ) ++last;
+         floor = last;
+
+         while( first < at && *first == '.' ) ++first;
+         while( last > at+1 && last[-1] == '.' ) --last;
+
+         std::string_view const candidate( first, last-first );
+         if( dfa::is_email_address( candidate ) ) {
+            callable( Match{ offset + ( first-begin ), candidate } );
+         }
+      }
+   }
+
+   std::string carry_{};
+   std::size_t position_{ 0UL };  // Position of the next chunk in the stream
+};
+
+using ScalarScanner = BasicScanner<ScalarSearch>;
+using SimdScanner   = BasicScanner<SimdSearch>;
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <Scanner.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <vector>
+
+
+// Creates log-like text of approximately 'size' bytes with an address every ~20 words; some
+// addresses are enclosed in brackets or end a sentence, some '@' are not part of an address
+std::string create_text( std::size_t size )
+{
+   static constexpr char const* words[] =
+      { "the", "mail", "from", "server", "delivery", "failed", "for", "user", "sent", "to",
+        "Please", "contact", "retry", "in", "seconds", "error", "queue", "id", "status", "OK" };
+   static constexpr char const* separators[] = { " ", " ", " ", ", ", ". ", "\n", ": " };
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk" };
+   static constexpr char const* noise[] =
+      { "@home", "root@localhost", "a@b", "x@y..z", "k@t-online.de", "@@", "me@.com" };
+
+   std::mt19937 rng{ 42U };
+   std::string text{};
+   text.reserve( size + 256UL );
+   while( text.size() < size ) {
+      auto const r = rng()%40U;
+      if( r < 2U ) {
+         std::string const address{ std::string{ locals[rng()%5U] } + std::to_string( rng()%1000U ) +
+                                    '@' + domains[rng()%3U] };
+         switch( rng()%4U ) {
+            case 0U: text += '<' + address + '>'; break;
+            case 1U: text += '(' + address + ')'; break;
+            case 2U: text += address + '.'; break;
+            default: text += address; break;
+         }
+      }
+      else if( r == 2U ) {
+         text += noise[rng()%7U];
+      }
+      else {
+         text += words[rng()%20U];
+      }
+      text += separators[rng()%7U];
+   }
+   return text;
+}
+
+struct Summary
+{
+   std::size_t count{ 0UL };
+   std::size_t checksum{ 0UL };  // Sum of the offsets and lengths of all matches
+
+   void add( std::size_t offset, std::size_t length ) noexcept
+   {
+      ++count;
+      checksum += offset*31UL + length;
+   }
+
+   bool operator==( Summary const& ) const = default;
+};
+
+template< typename Scanner >
+Summary scan( std::string_view text, std::size_t chunk_size )
+{
+   Summary summary{};
+   auto const callback = [&]( Match const& m ){ summary.add( m.offset, m.address.size() ); };
+
+   Scanner scanner{};
+   for( std::size_t pos=0UL; pos<text.size(); pos+=chunk_size ) {
+      std::string_view const chunk{ text.substr( pos, chunk_size ) };
+      scanner.feed( std::span<char const>( chunk.data(), chunk.size() ), callback );
+   }
+   scanner.finish( callback );
+   return summary;
+}
+
+Summary scan_regex( std::string const& text )
+{
+   static std::regex const pattern{
+      R"([A-Za-z0-9_]+(\.[A-Za-z0-9_]+)*@[A-Za-z0-9_]+(\.[A-Za-z0-9_]+)+)" };
+
+   Summary summary{};
+   for( std::sregex_iterator it{ text.begin(), text.end(), pattern }, end{}; it != end; ++it ) {
+      summary.add( std::size_t( it->position() ), std::size_t( it->length() ) );
+   }
+   return summary;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t size( 1UL << 26 );        // 64 MiB of text
+   constexpr std::size_t regex_size( 1UL << 22 );  // 4 MiB of text for 'std::regex'
+   constexpr std::size_t chunk_size( 1UL << 16 );  // Streaming in 64 KiB chunks
+
+   std::string const text{ create_text( size ) };
+   std::string const prefix{ text.substr( 0UL, text.find( '\n', regex_size ) ) };
+
+   std::cout << "\n Extracted email addresses:";
+   SimdScanner scanner{};
+   std::size_t shown{ 0UL };
+   scanner.feed( std::span<char const>( text.data(), 2048UL ), [&]( Match const& m ) {
+      if( shown++ < 3UL ) std::cout << "\n  " << EmailAddress{ std::string{ m.address } };
+   } );
+   std::cout << "\n";
+
+   Summary regex{}, scalar_prefix{}, scalar{}, simd{};
+   double const t1 = benchmark( [&]{ regex  = scan_regex( prefix ); } );
+   double const t2 = benchmark( [&]{ scalar = scan<ScalarScanner>( text, chunk_size ); } );
+   double const t3 = benchmark( [&]{ simd   = scan<SimdScanner>( text, chunk_size ); } );
+   scalar_prefix = scan<ScalarScanner>( prefix, chunk_size );
+
+   std::cout << "\n Scanning " << text.size() / 1e6 << " MB of text (" << simd.count
+             << " addresses)\n"
+             << "  std::regex:     " << prefix.size() / t1 / 1e6 << " MB/s ("
+             << regex.count << " addresses in the first " << prefix.size() / 1e6 << " MB)\n"
+             << "  Scalar scanner: " << text.size() / t2 / 1e6 << " MB/s\n"
+             << "  SIMD scanner:   " << text.size() / t3 / 1e6 << " MB/s\n\n";
+
+   if( scalar != simd || regex != scalar_prefix || scan<SimdScanner>( text, 7UL ) != simd ) {
+      std::cerr << " RESULTS DIFFER!\n";
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,259 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Split.cpp
+* \brief C++ Training - Example for precomputed local part, domain and TLD offsets
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the runtime of extracting the domain and the top-level domain of 10 million
+*       email addresses by searching 'value()' and by means of the 'domain()' and 'tld()'
+*       accessors. What is the cost of the precomputed offsets in terms of 'sizeof'?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+struct Result
+{
+   bool valid{ false };
+   std::size_t at{ 0UL };   // Position of the '@'
+   std::size_t dot{ 0UL };  // Position of the last dot (i.e. the dot in front of the TLD)
+};
+
+// Validates the given address in a single left-to-right pass and records the position of the
+// '@' and of the last dot on the way
+constexpr Result validate( std::string_view address ) noexcept
+{
+   Result result{};
+   State state{ State::Start };
+
+   for( std::size_t i=0UL; i<address.size(); ++i )
+   {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( address[i] )])];
+
+      if( state == State::Reject ) {
+         return result;
+      }
+      if( state == State::At ) {
+         result.at = i;
+      }
+      else if( state == State::TldStart ) {
+         result.dot = i;
+      }
+   }
+
+   result.valid = ( state == State::Tld );
+   return result;
+}
+
+} // namespace dfa
+
+
+static_assert( dfa::validate( "klaus.iglberger@gmx.de" ).at == 15UL );
+static_assert( dfa::validate( "klaus.iglberger@gmx.de" ).dot == 19UL );
+static_assert( dfa::validate( "k_i@mail.server.co.uk" ).dot == 18UL );
+
+
+// Email address, which remembers the position of the '@' and of the dot in front of the
+// top-level domain. Since the positions are found during validation anyway, the local part,
+// the domain and the top-level domain are available in O(1).
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( address_.size() > std::numeric_limits<std::uint16_t>::max() ) {
+         throw std::invalid_argument( "Email address too long" );
+      }
+
+      dfa::Result const result{ dfa::validate( address_ ) };
+      if( !result.valid ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+
+      at_  = static_cast<std::uint16_t>( result.at );
+      dot_ = static_cast<std::uint16_t>( result.dot );
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::validate( address_ ).valid; }
+
+   // "klaus.iglberger" for "klaus.iglberger@mail.server.co.uk"
+   std::string_view local_part() const noexcept
+   {
+      return std::string_view{ address_ }.substr( 0UL, at_ );
+   }
+
+   // "mail.server.co.uk" for "klaus.iglberger@mail.server.co.uk"
+   std::string_view domain() const noexcept
+   {
+      return std::string_view{ address_ }.substr( at_+1UL );
+   }
+
+   // "uk" for "klaus.iglberger@mail.server.co.uk"
+   std::string_view tld() const noexcept
+   {
+      return std::string_view{ address_ }.substr( dot_+1UL );
+   }
+
+ private:
+   std::string address_;
+   std::uint16_t at_{};   // Position of the '@'
+   std::uint16_t dot_{};  // Position of the dot in front of the top-level domain
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+std::vector<EmailAddress> create_addresses( std::size_t n )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk" };
+
+   std::mt19937 rng{ 42U };
+   std::vector<EmailAddress> addresses{};
+   addresses.reserve( n );
+   for( std::size_t i=0UL; i<n; ++i ) {
+      addresses.emplace_back( std::string{ locals[rng()%5U] } + std::to_string( rng()%10000U ) +
+                              '@' + domains[rng()%3U] );
+   }
+   return addresses;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 1000000UL );
+   constexpr std::size_t repetitions( 10UL );
+
+   EmailAddress const address{ "klaus.iglberger@mail.server.co.uk" };
+   std::cout << "\n Email address: " << address << "\n"
+             << "  local part = " << address.local_part() << "\n"
+             << "  domain     = " << address.domain() << "\n"
+             << "  tld        = " << address.tld() << "\n"
+             << "  sizeof(EmailAddress) = " << sizeof(EmailAddress)
+             << " (sizeof(std::string) = " << sizeof(std::string) << ")\n";
+
+   std::vector<EmailAddress> const addresses{ create_addresses( N ) };
+
+   // The checksums prevent the compiler from removing the extraction
+   std::size_t checksum1{ 0UL }, checksum2{ 0UL };
+
+   double const searching = benchmark( [&]{
+      for( std::size_t r=0UL; r<repetitions; ++r ) {
+         for( auto const& a : addresses ) {
+            std::string_view const value{ a.value() };
+            std::string_view const domain{ value.substr( value.find( '@' )+1UL ) };
+            std::string_view const tld{ domain.substr( domain.rfind( '.' )+1UL ) };
+            checksum1 += domain.size() + tld.front();
+         }
+      }
+   } );
+
+   double const precomputed = benchmark( [&]{
+      for( std::size_t r=0UL; r<repetitions; ++r ) {
+         for( auto const& a : addresses ) {
+            checksum2 += a.domain().size() + a.tld().front();
+         }
+      }
+   } );
+
+   std::cout << "\n Extracting domain and TLD of " << N*repetitions << " email addresses\n"
+             << "  Searching value():   " << searching << "s\n"
+             << "  Precomputed offsets: " << precomputed << "s\n\n";
+
+   if( checksum1 != checksum2 ) {
+      std::cerr << " RESULTS DIFFER!\n";
+   }
+
+   return EXIT_SUCCESS;
+}
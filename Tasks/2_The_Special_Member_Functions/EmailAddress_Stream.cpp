@@ -0,0 +1,368 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_Stream.cpp
+* \brief C++ Training - Example for the incremental validation of streamed email addresses
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the validation of newline-separated email addresses, which arrive in chunks of
+*       4 KiB, 64 KiB and 1 MiB, via a 'std::string' buffer (which collects incomplete lines)
+*       and via the 'StreamingValidator', which carries the state of the validation across
+*       chunk boundaries. Which copies does the 'StreamingValidator' avoid?
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr State next( State state, char c ) noexcept
+{
+   return transitions[std::size_t(state)]
+                     [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+}
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   State state{ State::Start };
+   for( char const c : address ) {
+      state = next( state, c );
+      if( state == State::Reject ) return false;
+   }
+   return state == State::Tld;
+}
+
+} // namespace dfa
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::is_email_address( address_ ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <StreamingValidator.h> ---------------------------------------------------------------------
+
+struct Record
+{
+   std::uint64_t offset;   // Position of the first character within the stream
+   std::size_t length;     // Number of characters (without the newline)
+   bool valid;
+   std::string_view text;  // The address for valid records (only valid during the callback)
+};
+
+// Resumable validator for a stream of newline-separated email addresses, which arrive in chunks
+// of arbitrary size. The state of the automaton is carried from one chunk to the next, i.e. no
+// character is ever validated twice. The only characters that are copied are the leading part
+// of a valid address that straddles a chunk boundary (such that the complete text of all valid
+// addresses can be passed to the callback).
+class StreamingValidator
+{
+ public:
+   // Validates the given chunk and calls the given callable for every completed address
+   template< typename Callable >
+   void feed( std::span<char const> chunk, Callable callable )
+   {
+      char const* const data{ chunk.data() };
+      std::size_t const size{ chunk.size() };
+      std::size_t begin{ 0UL };  // Begin of the current address within the chunk
+
+      for( std::size_t i=0UL; i<size; ++i )
+      {
+         if( data[i] == '\n' ) {
+            emit( std::string_view{ data+begin, i-begin }, callable );
+            begin = i+1UL;
+            start_ = position_ + begin;
+            continue;
+         }
+
+         state_ = dfa::next( state_, data[i] );
+
+         if( state_ == dfa::State::Reject ) {  // Skipping the rest of the line
+            void const* const eol{ std::memchr( data+i, '\n', size-i ) };
+            i = ( eol == nullptr ? size : static_cast<char const*>( eol ) - data ) - 1UL;
+         }
+      }
+
+      // Carrying the beginning of a potentially valid address to the next chunk
+      if( state_ != dfa::State::Reject ) {
+         carry_.append( data+begin, size-begin );
+      }
+      length_ += size-begin;
+      position_ += size;
+   }
+
+   // Completes the last address of the stream, if it is not terminated by a newline
+   template< typename Callable >
+   void finish( Callable callable )
+   {
+      if( length_ > 0UL ) {
+         emit( std::string_view{}, callable );
+      }
+   }
+
+ private:
+   template< typename Callable >
+   void emit( std::string_view tail, Callable& callable )
+   {
+      bool const valid{ state_ == dfa::State::Tld };
+      std::size_t const length{ length_ + tail.size() };
+
+      std::string_view text{};
+      if( valid ) {
+         if( carry_.empty() ) {
+            text = tail;
+         }
+         else {
+            carry_.append( tail );
+            text = carry_;
+         }
+      }
+
+      callable( Record{ start_, length, valid, text } );
+
+      state_ = dfa::State::Start;
+      carry_.clear();
+      length_ = 0UL;
+   }
+
+   dfa::State state_{ dfa::State::Start };
+   std::uint64_t position_{ 0UL };  // Stream position of the beginning of the next chunk
+   std::uint64_t start_{ 0UL };     // Stream position of the beginning of the current address
+   std::size_t length_{ 0UL };      // Length of the current address in previous chunks
+   std::string carry_{};            // Leading part of the current address from previous chunks
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <StreamingValidator.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+
+std::string create_stream( std::size_t n )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk" };
+   static constexpr char const* defects[] =
+      { "", "", "", "", "", "", "", "..", "@", "-" };
+
+   std::mt19937 rng{ 42U };
+   std::string stream{};
+   for( std::size_t i=0UL; i<n; ++i ) {
+      stream += locals[rng()%5U];
+      stream += std::to_string( rng()%10000U );
+      stream += defects[rng()%10U];
+      stream += '@';
+      stream += domains[rng()%3U];
+      stream += '\n';
+   }
+   return stream;
+}
+
+struct Summary
+{
+   std::size_t records{ 0UL };
+   std::size_t valid{ 0UL };
+   std::uint64_t checksum{ 0U };  // Sum over the offsets and lengths of all valid records
+
+   void add( std::uint64_t offset, std::size_t length, bool ok )
+   {
+      ++records;
+      if( ok ) {
+         ++valid;
+         checksum += offset*31U + length;
+      }
+   }
+
+   bool operator==( Summary const& ) const = default;
+};
+
+// Reference: collecting the chunks in a 'std::string' and validating all complete lines
+Summary validate_buffered( std::string_view stream, std::size_t chunk_size )
+{
+   Summary summary{};
+   std::string buffer{};
+   std::uint64_t consumed{ 0UL };
+
+   auto const validate_lines = [&]( bool last ) {
+      std::size_t begin{ 0UL };
+      for( std::size_t eol; ( eol = buffer.find( '\n', begin ) ) != std::string::npos; ) {
+         std::string const line{ buffer.substr( begin, eol-begin ) };
+         summary.add( consumed+begin, line.size(), dfa::is_email_address( line ) );
+         begin = eol+1UL;
+      }
+      if( last && begin < buffer.size() ) {
+         std::string const line{ buffer.substr( begin ) };
+         summary.add( consumed+begin, line.size(), dfa::is_email_address( line ) );
+         begin = buffer.size();
+      }
+      buffer.erase( 0UL, begin );
+      consumed += begin;
+   };
+
+   for( std::size_t pos=0UL; pos<stream.size(); pos+=chunk_size ) {
+      buffer.append( stream.substr( pos, chunk_size ) );
+      validate_lines( false );
+   }
+   validate_lines( true );
+
+   return summary;
+}
+
+Summary validate_streaming( std::string_view stream, std::size_t chunk_size )
+{
+   Summary summary{};
+   StreamingValidator validator{};
+
+   auto const record = [&]( Record const& r ){ summary.add( r.offset, r.length, r.valid ); };
+
+   for( std::size_t pos=0UL; pos<stream.size(); pos+=chunk_size ) {
+      std::string_view const chunk{ stream.substr( pos, chunk_size ) };
+      validator.feed( chunk, record );
+   }
+   validator.finish( record );
+
+   return summary;
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t N( 4000000UL );
+
+   std::string const stream{ create_stream( N ) };
+
+   std::cout << "\n Validating a stream of " << N << " addresses (" << stream.size() / 1e6
+             << " MB)\n";
+
+   // Every valid address must be reported with its complete text
+   {
+      std::size_t mismatches{ 0UL };
+      StreamingValidator validator{};
+      auto const check = [&]( Record const& r ) {
+         if( r.valid && r.text != std::string_view{ stream }.substr( r.offset, r.length ) ) {
+            ++mismatches;
+         }
+      };
+      for( std::size_t pos=0UL; pos<stream.size(); pos+=7UL ) {
+         validator.feed( std::string_view{ stream }.substr( pos, 7UL ), check );
+      }
+      validator.finish( check );
+      std::cout << "  Text check with 7 byte chunks: " << mismatches << " mismatches\n";
+   }
+
+   for( std::size_t const chunk_size : { 4096UL, 65536UL, 1048576UL } )
+   {
+      Summary buffered{}, streaming{};
+
+      double const t1 = benchmark( [&]{ buffered = validate_buffered( stream, chunk_size ); } );
+      double const t2 = benchmark( [&]{ streaming = validate_streaming( stream, chunk_size ); } );
+
+      std::cout << "\n " << chunk_size / 1024UL << " KiB chunks (" << streaming.valid << " of "
+                << streaming.records << " valid)\n"
+                << "  std::string buffer:  " << t1 << "s\n"
+                << "  StreamingValidator:  " << t2 << "s\n";
+
+      if( !( buffered == streaming ) ) {
+         std::cerr << "  RESULTS DIFFER!\n";
+      }
+   }
+
+   std::cout << "\n";
+
+   return EXIT_SUCCESS;
+}
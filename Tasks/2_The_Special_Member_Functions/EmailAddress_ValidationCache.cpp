@@ -0,0 +1,422 @@
+/**************************************************************************************************
+*
+* \file EmailAddress_ValidationCache.cpp
+* \brief C++ Training - Example for a bounded, thread-safe cache of validation results
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the throughput of validating a skewed stream of email addresses via the
+*       'EmailAddress' constructor and via a sharded cache of validation results for 1 to 32
+*       threads. How does the hit ratio depend on the size of the cache, and why does the cache
+*       also store invalid addresses?
+*
+*       Note: Please compile with optimization (e.g. -O2) for meaningful results.
+*
+**************************************************************************************************/
+
+
+//---- <EmailAddress.h> ---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dfa {
+
+enum class CharClass : std::uint8_t { Word, Dot, At, Other };
+
+// Character classes of all 256 characters: 'Word' refers to ASCII alphanumeric characters and
+// '_' (i.e. 'isalnum()' in the "C" locale), all non-ASCII characters are classified as 'Other'
+inline constexpr std::array<CharClass,256> char_classes = []{
+   std::array<CharClass,256> table{};
+   for( std::size_t c=0UL; c<256UL; ++c ) {
+      table[c] = ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
+                 ( c >= 'a' && c <= 'z' ) || c == '_' ? CharClass::Word
+               : c == '.' ? CharClass::Dot
+               : c == '@' ? CharClass::At
+               : CharClass::Other;
+   }
+   return table;
+}();
+
+// States of the automaton (see EmailAddress_DFA.cpp); 'Tld' is the only accepting state
+enum class State : std::uint8_t { Start, Local, LocalDot, At, Domain, TldStart, Tld, Reject };
+
+inline constexpr std::array<std::array<State,4>,8> transitions = []{
+   using enum State;
+   std::array<std::array<State,4>,8> table{};
+   //                                 Word     Dot       At      Other
+   table[std::size_t(Start)]    = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(Local)]    = {{ Local,  LocalDot, At,     Reject }};
+   table[std::size_t(LocalDot)] = {{ Local,  Reject,   Reject, Reject }};
+   table[std::size_t(At)]       = {{ Domain, Reject,   Reject, Reject }};
+   table[std::size_t(Domain)]   = {{ Domain, TldStart, Reject, Reject }};
+   table[std::size_t(TldStart)] = {{ Tld,    Reject,   Reject, Reject }};
+   table[std::size_t(Tld)]      = {{ Tld,    TldStart, Reject, Reject }};
+   table[std::size_t(Reject)]   = {{ Reject, Reject,   Reject, Reject }};
+   return table;
+}();
+
+constexpr bool is_email_address( std::string_view address ) noexcept
+{
+   State state{ State::Start };
+   for( char const c : address ) {
+      state = transitions[std::size_t(state)]
+                         [std::size_t(char_classes[static_cast<unsigned char>( c )])];
+      if( state == State::Reject ) return false;
+   }
+   return state == State::Tld;
+}
+
+} // namespace dfa
+
+
+class EmailAddress
+{
+ public:
+   explicit EmailAddress( std::string address )
+      : address_{std::move(address)}
+   {
+      if( !is_valid() ) {
+         throw std::invalid_argument( "Invalid email address" );
+      }
+   }
+
+   ~EmailAddress() = default;
+   EmailAddress( EmailAddress const& ) = default;
+   EmailAddress& operator=( EmailAddress const& ) = default;
+   // Move constructor explicitly omitted
+   // Move assignment operator explicitly omitted
+
+   std::string const& value() const { return address_; }
+   bool is_valid() const { return dfa::is_email_address( address_ ); }
+
+ private:
+   std::string address_;
+};
+
+std::ostream& operator<<( std::ostream& os, EmailAddress const& address )
+{
+   return os << address.value() << " (" << ( address.is_valid() ? "valid" : "INVALID" ) << ')';
+}
+
+
+//---- <ValidationCache.h> ------------------------------------------------------------------------
+
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Hash of the unvalidated characters, 8 characters per step
+inline std::uint64_t hash( std::string_view text ) noexcept
+{
+   std::uint64_t h{ 0x9e3779b97f4a7c15ULL ^ text.size() };
+   for( std::size_t i=0UL; i<text.size(); i+=8UL ) {
+      std::uint64_t word{ 0U };
+      std::memcpy( &word, text.data()+i, std::min( text.size()-i, 8UL ) );
+      h = ( h ^ word ) * 0xff51afd7ed558ccdULL;
+      h ^= h >> 32;
+   }
+   h *= 0xc4ceb9fe1a85ec53ULL;
+   h ^= h >> 33;
+   return h;
+}
+
+
+// Bounded cache of validation results. A valid address maps to an immutable, shared
+// 'EmailAddress', an invalid address to a null pointer, i.e. repeated invalid addresses are not
+// re-validated either. The cache is split into 64 shards by the upper bits of the hash, each
+// protected by its own mutex. Every shard holds a fixed number of entries, which are indexed
+// by an open addressing table with linear probing on the lower bits of the hash, and evicts
+// via the CLOCK algorithm: a hit sets the reference bit of the entry, the clock hand clears
+// the reference bits and evicts the first entry without one.
+class ValidationCache
+{
+ public:
+   using Pointer = std::shared_ptr<EmailAddress const>;
+
+   struct Statistics
+   {
+      std::size_t hits{ 0UL };
+      std::size_t misses{ 0UL };
+      std::size_t evictions{ 0UL };
+      std::size_t size{ 0UL };
+
+      double hit_ratio() const noexcept
+      {
+         return hits + misses == 0UL ? 0.0 : double( hits ) / double( hits + misses );
+      }
+   };
+
+   explicit ValidationCache( std::size_t capacity )
+   {
+      std::size_t const per_shard{ std::max( ( capacity + shards - 1UL ) / shards, 1UL ) };
+      for( Shard& shard : shards_ ) {
+         shard.entries.resize( per_shard );
+         shard.slots.resize( std::bit_ceil( 2UL*per_shard ) );
+      }
+   }
+
+   // Returns the cached address or a null pointer for an invalid address; on a miss the
+   // address is validated without holding the lock of the shard
+   Pointer validate( std::string_view address )
+   {
+      std::uint64_t const h{ hash( address ) };
+      Shard& shard{ shards_[h >> ( 64U - shard_bits )] };
+
+      {
+         std::lock_guard lock{ shard.mutex };
+         if( std::size_t const slot{ find( shard, h, address ) }; shard.slots[slot] != 0U ) {
+            Entry& entry{ shard.entries[shard.slots[slot]-1U] };
+            entry.referenced = true;
+            ++shard.hits;
+            return entry.address;
+         }
+      }
+
+      Pointer result{ dfa::is_email_address( address )
+                      ? std::make_shared<EmailAddress const>( std::string{ address } )
+                      : nullptr };
+
+      std::lock_guard lock{ shard.mutex };
+      ++shard.misses;
+      if( std::size_t const slot{ find( shard, h, address ) }; shard.slots[slot] == 0U ) {
+         insert( shard, h, address, result );
+      }
+      return result;
+   }
+
+   Statistics statistics() const
+   {
+      Statistics stats{};
+      for( Shard const& shard : shards_ ) {
+         std::lock_guard lock{ shard.mutex };
+         stats.hits      += shard.hits;
+         stats.misses    += shard.misses;
+         stats.evictions += shard.evictions;
+         stats.size      += shard.size;
+      }
+      return stats;
+   }
+
+ private:
+   static constexpr unsigned shard_bits{ 6U };
+   static constexpr std::size_t shards{ 1UL << shard_bits };
+
+   struct Entry
+   {
+      std::string key{};
+      std::uint64_t hash{ 0U };
+      Pointer address{};
+      bool used{ false };
+      bool referenced{ false };
+   };
+
+   struct alignas(64) Shard
+   {
+      mutable std::mutex mutex{};
+      std::vector<Entry> entries{};
+      std::vector<std::uint32_t> slots{};  // Index of the entry + 1, 0 marks an empty slot
+      std::size_t hand{ 0UL };
+      std::size_t size{ 0UL };
+      std::size_t hits{ 0UL };
+      std::size_t misses{ 0UL };
+      std::size_t evictions{ 0UL };
+   };
+
+   // Returns the slot of the given address or the empty slot, which ends the probe sequence
+   static std::size_t find( Shard const& shard, std::uint64_t h, std::string_view address )
+   {
+      std::size_t const mask{ shard.slots.size()-1UL };
+      std::size_t i{ h & mask };
+      for( ; shard.slots[i] != 0U; i=(i+1UL)&mask ) {
+         Entry const& entry{ shard.entries[shard.slots[i]-1U] };
+         if( entry.hash == h && entry.key == address ) break;
+      }
+      return i;
+   }
+
+   // Removes the given slot and shifts the following slots of the cluster backwards, such
+   // that no probe sequence is interrupted (i.e. no tombstones are needed)
+   static void erase( Shard& shard, std::size_t i )
+   {
+      std::size_t const mask{ shard.slots.size()-1UL };
+      for( std::size_t j=(i+1UL)&mask; shard.slots[j] != 0U; j=(j+1UL)&mask ) {
+         std::size_t const home{ shard.entries[shard.slots[j]-1U].hash & mask };
+         if( ( ( j-home ) & mask ) >= ( ( j-i ) & mask ) ) {
+            shard.slots[i] = shard.slots[j];
+            i = j;
+         }
+      }
+      shard.slots[i] = 0U;
+   }
+
+   static void insert( Shard& shard, std::uint64_t h, std::string_view address, Pointer result )
+   {
+      // Advancing the clock hand to the first unused or unreferenced entry
+      while( shard.entries[shard.hand].used && shard.entries[shard.hand].referenced ) {
+         shard.entries[shard.hand].referenced = false;
+         shard.hand = ( shard.hand + 1UL ) % shard.entries.size();
+      }
+
+      Entry& entry{ shard.entries[shard.hand] };
+      if( entry.used ) {
+         erase( shard, find( shard, entry.hash, entry.key ) );
+         ++shard.evictions;
+      }
+      else {
+         ++shard.size;
+      }
+
+      entry.key.assign( address );
+      entry.hash = h;
+      entry.address = std::move( result );
+      entry.used = true;
+      entry.referenced = false;
+      shard.slots[find( shard, h, address )] = static_cast<std::uint32_t>( shard.hand+1UL );
+
+      shard.hand = ( shard.hand + 1UL ) % shard.entries.size();
+   }
+
+   std::array<Shard,shards> shards_{};
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <EmailAddress.h>
+//#include <ValidationCache.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+
+// Creates 'n' different addresses, of which approximately 5% are invalid
+std::vector<std::string> create_population( std::size_t n )
+{
+   static constexpr char const* locals[] =
+      { "klaus", "klaus.iglberger", "k_iglberger", "info", "a.b.c" };
+   static constexpr char const* domains[] =
+      { "gmx.de", "example.com", "mail.server.co.uk" };
+
+   std::mt19937 rng{ 42U };
+   std::vector<std::string> population{};
+   population.reserve( n );
+   for( std::size_t i=0UL; i<n; ++i ) {
+      population.push_back( std::string{ locals[i%5U] } + std::to_string( i ) +
+                            ( rng()%20U == 0U ? ".." : "" ) + '@' + domains[rng()%3U] );
+   }
+   std::shuffle( population.begin(), population.end(), rng );
+   return population;
+}
+
+// Creates 'n' indices into the population, following a Zipf distribution
+std::vector<std::uint32_t> create_queries( std::size_t n, std::size_t population )
+{
+   std::vector<double> weights( population );
+   for( std::size_t i=0UL; i<population; ++i ) {
+      weights[i] = 1.0 / double( i+1UL );
+   }
+
+   std::mt19937 rng{ 42U };
+   std::discrete_distribution<std::uint32_t> zipf( weights.begin(), weights.end() );
+   std::vector<std::uint32_t> queries( n );
+   for( auto& q : queries ) q = zipf( rng );
+   return queries;
+}
+
+// Runs 'work(begin, end)' on 'threads' disjoint slices of [0,n) (fork-join)
+template< typename Callable >
+void parallel_for( std::size_t n, std::size_t threads, Callable work )
+{
+   std::vector<std::jthread> workers{};
+   for( std::size_t t=0UL; t<threads; ++t ) {
+      workers.emplace_back( work, n*t/threads, n*(t+1UL)/threads );
+   }
+}
+
+template< typename Callable >
+double benchmark( Callable callable )
+{
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+   return elapsedTime.count();
+}
+
+
+int main()
+{
+   constexpr std::size_t P( 100000UL );   // Number of different addresses
+   constexpr std::size_t Q( 4000000UL );  // Number of validations
+   constexpr std::size_t C( 10000UL );    // Capacity of the cache
+
+   std::vector<std::string> const population{ create_population( P ) };
+   std::vector<std::uint32_t> const queries{ create_queries( Q, P ) };
+
+   std::cout << "\n Validating " << Q << " addresses out of " << P
+             << " (Zipf distribution), cache capacity " << C << "\n"
+             << "  threads   constructor [M/s]   cache [M/s]   hit ratio\n";
+
+   for( std::size_t threads : { 1UL, 2UL, 4UL, 8UL, 16UL, 32UL } )
+   {
+      std::atomic<std::size_t> valid1{ 0UL }, valid2{ 0UL };
+
+      double const constructor = benchmark( [&]{
+         parallel_for( Q, threads, [&]( std::size_t begin, std::size_t end ) {
+            std::size_t valid{ 0UL };
+            for( std::size_t i=begin; i<end; ++i ) {
+               try {
+                  EmailAddress const address{ population[queries[i]] };
+                  ++valid;
+               }
+               catch( std::invalid_argument const& ) {}
+            }
+            valid1 += valid;
+         } );
+      } );
+
+      ValidationCache cache{ C };
+      double const cached = benchmark( [&]{
+         parallel_for( Q, threads, [&]( std::size_t begin, std::size_t end ) {
+            std::size_t valid{ 0UL };
+            for( std::size_t i=begin; i<end; ++i ) {
+               valid += ( cache.validate( population[queries[i]] ) != nullptr );
+            }
+            valid2 += valid;
+         } );
+      } );
+
+      std::cout << "  " << std::setw(7) << threads
+                << "   " << std::setw(17) << Q / constructor / 1e6
+                << "   " << std::setw(11) << Q / cached / 1e6
+                << "   " << std::setw(9) << cache.statistics().hit_ratio() << "\n";
+
+      if( valid1 != valid2 ) {
+         std::cerr << " RESULTS DIFFER!\n";
+      }
+   }
+
+   std::cout << "\n";
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,404 @@
+/**************************************************************************************************
+*
+* \file HugePageAllocator.cpp
+* \brief C++ Training - Example for mmap-based allocation with transparent huge pages (Linux)
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Compare the number of page faults, dTLB misses and the runtime of ...
+*       1) ... a growing 'std::vector' of strings with the default allocator and with the
+*              'MmapAllocator', which requests transparent huge pages;
+*       2) ... a growing array of 'double' values in a 'std::vector' and in a 'MappedBuffer',
+*              which grows in place via 'mremap()' instead of copying;
+*       3) ... the construction of a large 'D' (see CopyControl.cpp) via 'new[]' and via a
+*              'MappedBuffer'.
+*
+**************************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+//---- <MmapAllocator.h> --------------------------------------------------------------------------
+
+constexpr std::size_t huge_page_size{ 2UL*1024UL*1024UL };
+
+inline std::size_t round_up_to_pages( std::size_t bytes )
+{
+   static std::size_t const page_size{ static_cast<std::size_t>( ::sysconf( _SC_PAGESIZE ) ) };
+   return ( bytes + page_size - 1UL ) / page_size * page_size;
+}
+
+inline void advise_huge_pages( void* ptr, std::size_t bytes )
+{
+   if( bytes >= huge_page_size ) {
+      ::madvise( ptr, bytes, MADV_HUGEPAGE );  // Only a hint; failure is not an error
+   }
+}
+
+inline void* map_memory( std::size_t bytes )
+{
+   void* const ptr = ::mmap( nullptr, bytes, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+   if( ptr == MAP_FAILED ) {
+      throw std::bad_alloc{};
+   }
+   advise_huge_pages( ptr, bytes );
+   return ptr;
+}
+
+
+// Standard conforming allocator, which maps every allocation directly from the operating system
+// and requests transparent huge pages for all allocations of at least 2 MiB. Since every
+// allocation costs a system call, the allocator is only suited for few large allocations.
+template< typename T >
+class MmapAllocator
+{
+ public:
+   using value_type = T;
+
+   MmapAllocator() = default;
+
+   template< typename U >
+   MmapAllocator( MmapAllocator<U> const& ) noexcept {}
+
+   T* allocate( std::size_t n )
+   {
+      if( n > std::size_t(-1) / sizeof(T) ) {
+         throw std::bad_array_new_length{};
+      }
+      return static_cast<T*>( map_memory( round_up_to_pages( std::max( n, 1UL )*sizeof(T) ) ) );
+   }
+
+   void deallocate( T* ptr, std::size_t n ) noexcept
+   {
+      ::munmap( ptr, round_up_to_pages( std::max( n, 1UL )*sizeof(T) ) );
+   }
+
+   template< typename U >
+   bool operator==( MmapAllocator<U> const& ) const noexcept { return true; }
+};
+
+
+//---- <MappedBuffer.h> ---------------------------------------------------------------------------
+
+// Growable buffer of trivially copyable elements in memory mapped via 'mmap()'. On growth, the
+// mapping is extended via 'mremap()', which either grows in place or moves the page table
+// entries, but never copies the elements.
+template< typename T >
+class MappedBuffer
+{
+ public:
+   static_assert( std::is_trivially_copyable_v<T>, "Trivially copyable type required" );
+
+   MappedBuffer() = default;
+
+   explicit MappedBuffer( std::size_t n )
+   {
+      resize( n );
+   }
+
+   ~MappedBuffer()
+   {
+      if( data_ != nullptr ) {
+         ::munmap( data_, bytes_ );
+      }
+   }
+
+   MappedBuffer( MappedBuffer const& ) = delete;
+   MappedBuffer& operator=( MappedBuffer const& ) = delete;
+
+   MappedBuffer( MappedBuffer&& other ) noexcept
+      : data_    { std::exchange( other.data_, nullptr ) }
+      , size_    { std::exchange( other.size_, 0UL ) }
+      , capacity_{ std::exchange( other.capacity_, 0UL ) }
+      , bytes_   { std::exchange( other.bytes_, 0UL ) }
+   {}
+
+   MappedBuffer& operator=( MappedBuffer&& other ) noexcept
+   {
+      MappedBuffer tmp{ std::move(other) };
+      std::swap( data_, tmp.data_ );
+      std::swap( size_, tmp.size_ );
+      std::swap( capacity_, tmp.capacity_ );
+      std::swap( bytes_, tmp.bytes_ );
+      return *this;
+   }
+
+   // Newly added elements are zero-initialized. Freshly mapped anonymous memory is zero already,
+   // thus only the elements within the previous capacity (e.g. after shrinking) are cleared.
+   void resize( std::size_t n )
+   {
+      if( n > size_ && size_ < capacity_ ) {
+         std::memset( data_+size_, 0, ( std::min( n, capacity_ ) - size_ ) * sizeof(T) );
+      }
+      if( n > capacity_ ) {
+         reserve( n );
+      }
+      size_ = n;
+   }
+
+   void reserve( std::size_t n )
+   {
+      if( n <= capacity_ ) return;
+
+      std::size_t const bytes{ round_up_to_pages( n*sizeof(T) ) };
+
+      if( data_ == nullptr ) {
+         data_ = static_cast<T*>( map_memory( bytes ) );
+      }
+      else {
+         void* const ptr = ::mremap( data_, bytes_, bytes, MREMAP_MAYMOVE );
+         if( ptr == MAP_FAILED ) {
+            throw std::bad_alloc{};
+         }
+         data_ = static_cast<T*>( ptr );
+         advise_huge_pages( data_, bytes );
+      }
+
+      bytes_ = bytes;
+      capacity_ = bytes / sizeof(T);
+   }
+
+   void push_back( T const& value )
+   {
+      if( size_ == capacity_ ) {
+         reserve( std::max( 2UL*capacity_, huge_page_size / sizeof(T) ) );
+      }
+      data_[size_++] = value;
+   }
+
+   std::size_t size()     const noexcept { return size_; }
+   std::size_t capacity() const noexcept { return capacity_; }
+
+   T*       data()       noexcept { return data_; }
+   T const* data() const noexcept { return data_; }
+
+   T&       operator[]( std::size_t i )       noexcept { return data_[i]; }
+   T const& operator[]( std::size_t i ) const noexcept { return data_[i]; }
+
+   T*       begin()       noexcept { return data_; }
+   T const* begin() const noexcept { return data_; }
+   T*       end()         noexcept { return data_+size_; }
+   T const* end()   const noexcept { return data_+size_; }
+
+ private:
+   T* data_{ nullptr };
+   std::size_t size_{ 0UL };
+   std::size_t capacity_{ 0UL };
+   std::size_t bytes_{ 0UL };
+};
+
+
+//---- <D.h> --------------------------------------------------------------------------------------
+
+// Move-only variant of class 'D' from CopyControl.cpp, which stores its values in a 'MappedBuffer'
+class D
+{
+ public:
+   explicit D( std::size_t n )
+      : v_( n )
+   {
+      std::iota( v_.begin(), v_.end(), 1.0 );
+   }
+
+   void append( double value ) { v_.push_back( value ); }
+
+   std::size_t size() const noexcept { return v_.size(); }
+   double sum() const { return std::accumulate( v_.begin(), v_.end(), 0.0 ); }
+
+ private:
+   MappedBuffer<double> v_;
+};
+
+
+//---- <String.h> ---------------------------------------------------------------------------------
+
+struct String
+{
+ public:
+   String( const char* s )
+      : s_{ s }
+   {}
+
+   String( std::string s )
+      : s_{ std::move(s) }
+   {}
+
+   ~String() = default;
+   String( const String& ) = default;
+   String& operator=( const String& ) = default;
+   String( String&& ) noexcept(true) = default;
+   String& operator=( String&& ) noexcept(true) = default;
+
+ private:
+   std::string s_;
+};
+
+
+//---- <Measurement.h> ----------------------------------------------------------------------------
+
+// RAII wrapper for a dTLB read miss counter via 'perf_event_open()'. In case the counter is not
+// available (e.g. due to 'perf_event_paranoid' or within a container), 'valid()' returns false.
+class DTLBMissCounter
+{
+ public:
+   DTLBMissCounter()
+   {
+      perf_event_attr attr{};
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.size = sizeof(attr);
+      attr.config = PERF_COUNT_HW_CACHE_DTLB
+                  | ( PERF_COUNT_HW_CACHE_OP_READ << 8 )
+                  | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fd_ = static_cast<int>( ::syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 ) );
+   }
+
+   ~DTLBMissCounter() { if( valid() ) ::close( fd_ ); }
+
+   DTLBMissCounter( DTLBMissCounter const& ) = delete;
+   DTLBMissCounter& operator=( DTLBMissCounter const& ) = delete;
+
+   bool valid() const noexcept { return fd_ >= 0; }
+
+   void start()
+   {
+      if( !valid() ) return;
+      ::ioctl( fd_, PERF_EVENT_IOC_RESET, 0 );
+      ::ioctl( fd_, PERF_EVENT_IOC_ENABLE, 0 );
+   }
+
+   std::uint64_t stop()
+   {
+      std::uint64_t count{};
+      if( !valid() ) return count;
+      ::ioctl( fd_, PERF_EVENT_IOC_DISABLE, 0 );
+      if( ::read( fd_, &count, sizeof(count) ) != sizeof(count) ) {
+         count = 0U;
+      }
+      return count;
+   }
+
+ private:
+   int fd_{ -1 };
+};
+
+inline long minor_page_faults()
+{
+   rusage usage{};
+   ::getrusage( RUSAGE_SELF, &usage );
+   return usage.ru_minflt;
+}
+
+template< typename Callable >
+void measure( char const* label, Callable callable )
+{
+   DTLBMissCounter counter{};
+
+   long const faults{ minor_page_faults() };
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   counter.start();
+   start = std::chrono::high_resolution_clock::now();
+
+   callable();
+
+   end = std::chrono::high_resolution_clock::now();
+   std::uint64_t const misses{ counter.stop() };
+   const std::chrono::duration<double> elapsedTime( end - start );
+
+   std::cout << "  " << label << ": " << elapsedTime.count() << "s, "
+             << ( minor_page_faults() - faults ) << " page faults, ";
+   if( counter.valid() ) {
+      std::cout << misses << " dTLB misses\n";
+   }
+   else {
+      std::cout << "dTLB misses n/a\n";
+   }
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+int main()
+{
+   constexpr size_t N( 5000000 );
+   constexpr size_t M( 64UL*1024UL*1024UL );
+
+   double sink{};
+
+   std::cout << "\n Growing a vector of " << N << " strings\n";
+
+   measure( "std::allocator  ", [&]{
+      std::vector<String> v;
+      for( size_t i=0UL; i<N; ++i ) {
+         v.emplace_back( "A long string of 30 characters" );
+      }
+   } );
+
+   measure( "MmapAllocator   ", [&]{
+      std::vector<String,MmapAllocator<String>> v;
+      for( size_t i=0UL; i<N; ++i ) {
+         v.emplace_back( "A long string of 30 characters" );
+      }
+   } );
+
+   std::cout << "\n Growing an array of " << M << " doubles\n";
+
+   measure( "std::vector     ", [&]{
+      std::vector<double> v;
+      for( size_t i=0UL; i<M; ++i ) {
+         v.push_back( static_cast<double>( i ) );
+      }
+      sink += v.back();
+   } );
+
+   measure( "MappedBuffer    ", [&]{
+      D d( 0UL );
+      for( size_t i=0UL; i<M; ++i ) {
+         d.append( static_cast<double>( i ) );
+      }
+      sink += static_cast<double>( d.size() );
+   } );
+
+   std::cout << "\n Constructing and summing a D of " << M << " doubles\n";
+
+   measure( "new double[]    ", [&]{
+      std::unique_ptr<double[]> v{ new double[M] };
+      std::iota( v.get(), v.get()+M, 1.0 );
+      sink += std::accumulate( v.get(), v.get()+M, 0.0 );
+   } );
+
+   measure( "MappedBuffer    ", [&]{
+      D d( M );
+      sink += d.sum();
+   } );
+
+   std::cout << "\n (checksum " << sink << ")\n\n";
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,277 @@
+/**************************************************************************************************
+*
+* \file MoveNoexceptMatrix.cpp
+* \brief C++ Training - Benchmark matrix for the influence of 'noexcept' move operations
+*
+* Copyright (C) 2015-2023 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the C++ training by Klaus Iglberger. The file may only be used in the
+* context of the C++ training or with explicit agreement by Klaus Iglberger.
+*
+* Task: Examine the generated benchmark matrix. For which containers, which kinds of move
+*       operations and which payload sizes are elements copied instead of moved during growth?
+*       How does this affect the runtime and the peak memory consumption?
+*
+**************************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+//---- <TrackingAllocator.h> ----------------------------------------------------------------------
+
+struct MemoryStatistics
+{
+   static inline std::size_t current{ 0UL };
+   static inline std::size_t peak{ 0UL };
+
+   static void reset() noexcept { current = 0UL; peak = 0UL; }
+};
+
+// Allocator, which keeps track of the currently allocated and the peak number of bytes
+template< typename T >
+class TrackingAllocator
+{
+ public:
+   using value_type = T;
+
+   TrackingAllocator() = default;
+
+   template< typename U >
+   TrackingAllocator( TrackingAllocator<U> const& ) noexcept {}
+
+   T* allocate( std::size_t n )
+   {
+      T* const ptr = std::allocator<T>{}.allocate( n );
+      MemoryStatistics::current += n*sizeof(T);
+      MemoryStatistics::peak = std::max( MemoryStatistics::peak, MemoryStatistics::current );
+      return ptr;
+   }
+
+   void deallocate( T* ptr, std::size_t n ) noexcept
+   {
+      MemoryStatistics::current -= n*sizeof(T);
+      std::allocator<T>{}.deallocate( ptr, n );
+   }
+
+   template< typename U >
+   bool operator==( TrackingAllocator<U> const& ) const noexcept { return true; }
+};
+
+
+//---- <Element.h> --------------------------------------------------------------------------------
+
+enum class MoveKind
+{
+   Noexcept,            // Move operations declared 'noexcept'
+   PotentiallyThrowing, // Move operations without 'noexcept'
+   CopyOnly             // No move operations; rvalues are copied
+};
+
+constexpr char const* to_string( MoveKind kind )
+{
+   switch( kind ) {
+      case MoveKind::Noexcept:            return "noexcept";
+      case MoveKind::PotentiallyThrowing: return "throwing";
+      case MoveKind::CopyOnly:            return "copy-only";
+   }
+   return "";
+}
+
+struct OperationCounters
+{
+   static inline std::size_t copies{ 0UL };
+   static inline std::size_t moves{ 0UL };
+
+   static void reset() noexcept { copies = 0UL; moves = 0UL; }
+};
+
+// Element type with an instrumented copy constructor and (depending on the given 'MoveKind') an
+// instrumented move constructor. The payload is a heap-allocated string of 'Size' characters.
+template< MoveKind Kind, std::size_t Size >
+class Element
+{
+ public:
+   using String = std::basic_string<char,std::char_traits<char>,TrackingAllocator<char>>;
+
+   Element()
+      : payload_( Size, 'x' )
+   {}
+
+   ~Element() = default;
+
+   Element( Element const& other )
+      : payload_{ other.payload_ }
+   {
+      ++OperationCounters::copies;
+   }
+
+   Element& operator=( Element const& other )
+   {
+      payload_ = other.payload_;
+      ++OperationCounters::copies;
+      return *this;
+   }
+
+   Element( Element&& other ) noexcept( Kind == MoveKind::Noexcept )
+      requires ( Kind != MoveKind::CopyOnly )
+      : payload_{ std::move(other.payload_) }
+   {
+      ++OperationCounters::moves;
+   }
+
+   Element& operator=( Element&& other ) noexcept( Kind == MoveKind::Noexcept )
+      requires ( Kind != MoveKind::CopyOnly )
+   {
+      payload_ = std::move(other.payload_);
+      ++OperationCounters::moves;
+      return *this;
+   }
+
+ private:
+   String payload_;
+};
+
+
+//---- <GrowthVector.h> ---------------------------------------------------------------------------
+
+// Minimal vector with a growth factor of 1.5. As 'std::vector', it relocates its elements via
+// 'std::move_if_noexcept()' to provide the strong exception safety guarantee for 'emplace_back()'.
+template< typename T, typename Alloc = std::allocator<T> >
+class GrowthVector
+{
+ public:
+   using Traits = std::allocator_traits<Alloc>;
+
+   GrowthVector() = default;
+
+   ~GrowthVector()
+   {
+      std::destroy( data_, data_+size_ );
+      if( data_ != nullptr ) {
+         Traits::deallocate( alloc_, data_, capacity_ );
+      }
+   }
+
+   GrowthVector( GrowthVector const& ) = delete;
+   GrowthVector& operator=( GrowthVector const& ) = delete;
+
+   template< typename... Args >
+   T& emplace_back( Args&&... args )
+   {
+      if( size_ == capacity_ ) {
+         grow( std::max( capacity_ + capacity_/2UL, std::size_t{4} ) );
+      }
+      T* const element = std::construct_at( data_+size_, std::forward<Args>(args)... );
+      ++size_;
+      return *element;
+   }
+
+   std::size_t size() const noexcept { return size_; }
+
+ private:
+   void grow( std::size_t capacity )
+   {
+      T* const data = Traits::allocate( alloc_, capacity );
+      std::size_t i{ 0UL };
+      try {
+         for( ; i<size_; ++i ) {
+            std::construct_at( data+i, std::move_if_noexcept( data_[i] ) );
+         }
+      }
+      catch( ... ) {
+         std::destroy( data, data+i );
+         Traits::deallocate( alloc_, data, capacity );
+         throw;
+      }
+      std::destroy( data_, data_+size_ );
+      if( data_ != nullptr ) {
+         Traits::deallocate( alloc_, data_, capacity_ );
+      }
+      data_ = data;
+      capacity_ = capacity;
+   }
+
+   Alloc alloc_{};
+   T* data_{ nullptr };
+   std::size_t size_{ 0UL };
+   std::size_t capacity_{ 0UL };
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+constexpr size_t N( 500000 );
+
+template< template<typename,typename> class Container, MoveKind Kind, std::size_t Size >
+void run_cell( char const* name )
+{
+   using T = Element<Kind,Size>;
+
+   MemoryStatistics::reset();
+   OperationCounters::reset();
+
+   std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+   start = std::chrono::high_resolution_clock::now();
+
+   {
+      Container<T,TrackingAllocator<T>> c;
+      for( size_t i=0UL; i<N; ++i ) {
+         c.emplace_back();
+      }
+   }
+
+   end = std::chrono::high_resolution_clock::now();
+   const std::chrono::duration<double> elapsedTime( end - start );
+
+   std::cout << " " << std::left << std::setw(14) << name
+             << std::setw(11) << to_string( Kind )
+             << std::right << std::setw(8) << Size
+             << std::setw(12) << std::fixed << std::setprecision(4) << elapsedTime.count()
+             << std::setw(12) << OperationCounters::copies
+             << std::setw(12) << OperationCounters::moves
+             << std::setw(12) << std::setprecision(1) << MemoryStatistics::peak / 1048576.0
+             << "\n";
+}
+
+template< template<typename,typename> class Container, MoveKind Kind, std::size_t... Sizes >
+void run_row( char const* name, std::index_sequence<Sizes...> )
+{
+   ( run_cell<Container,Kind,Sizes>( name ), ... );
+}
+
+template< template<typename,typename> class Container >
+void run_container( char const* name )
+{
+   using Sizes = std::index_sequence<16,64,256>;
+
+   run_row<Container,MoveKind::Noexcept>( name, Sizes{} );
+   run_row<Container,MoveKind::PotentiallyThrowing>( name, Sizes{} );
+   run_row<Container,MoveKind::CopyOnly>( name, Sizes{} );
+}
+
+
+int main()
+{
+   std::cout << "\n Inserting " << N << " elements via 'emplace_back()'\n\n"
+             << " Container     Move        Payload    Time [s]      Copies       Moves   Peak [MiB]\n"
+             << " -----------------------------------------------------------------------------------\n";
+
+   run_container<std::vector>( "std::vector" );
+   run_container<std::deque>( "std::deque" );
+   run_container<GrowthVector>( "GrowthVector" );
+
+   std::cout << "\n";
+
+   return EXIT_SUCCESS;
+}